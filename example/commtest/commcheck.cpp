@@ -0,0 +1,1189 @@
+//
+//  commcheck.cpp
+//
+//  Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+//                    Kyushu University.  All rights reserved.
+//
+
+// Execution
+// $ mpirun -np X commcheck nx ny nz gc grid mode
+// (ex)
+// $ mpirun -np 8 commcheck 16 16 16 2 cell plan
+
+// 袖通信の値の検証
+// 内点に全体インデクスをエンコードした値をセットし、通信後の袖の値が
+// 隣接ランクの対応する内点の値と一致するかを確認する
+// 不一致があれば終了コード1を返す
+// overlapでは、境界領域を返した時点で依存する袖が受信済みであること、
+// 内部領域と境界領域が内点を重複なく覆うことも確認する
+// deepでは、平滑化を進めた内点の値を毎ステップ通信した場合と比較する
+// simdでは、X面のpack, unpackの命令セットを切り替え、1スレッドと3スレッドで確認する
+// ncompoでは、成分数2, 4, 5の配列を各comm_modeで確認する
+// aosでは、成分が最内の配列 v(l,i,j,k) を確認する
+// ompでは、3スレッドで全方向を1つの並列領域でpack, unpackする場合を確認する
+// thresholdでは、pack, unpackを常に並列、常に逐次とした場合を確認する
+// typesでは、1, 2, 16バイトの整数、半精度、複素数、登録した利用者の型の配列を確認する
+// periodicでは、周期境界の分割（分割数1の軸を含む）で各comm_modeを確認する
+// maskでは、袖を受信する方向を選んだ通信で、選んだ方向の袖のみが埋まることを確認する
+// 通信クラスには複製したコミュニケータを与える
+
+#include <CB_SubDomain.h>
+#include <CB_Comm.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <complex>
+
+#define REAL_TYPE double
+
+
+// 周期境界の軸の周期、0は周期境界なし (periodicモード)
+// nodeでは両端の格子点を同一点とするので、周期は格子点数-1
+static int period[3] = {0, 0, 0};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 全体インデクス(C表記)と成分から値を作成
+// 周期境界の軸は、周期で折り返したインデクスとする
+REAL_TYPE encode(const int* G_size, const int Gi, const int Gj, const int Gk, const int l)
+{
+  int gi = ( period[0] > 0 ) ? (Gi % period[0] + period[0]) % period[0] : Gi;
+  int gj = ( period[1] > 0 ) ? (Gj % period[1] + period[1]) % period[1] : Gj;
+  int gk = ( period[2] > 0 ) ? (Gk % period[2] + period[2]) % period[2] : Gk;
+
+  return (REAL_TYPE)( ( (size_t)l * (G_size[2]+2) + gk ) * (G_size[1]+2) * (G_size[0]+2)
+                    + (size_t)gj * (G_size[0]+2) + gi );
+}
+
+
+// 利用者の型 (typesモード)
+struct Pair {
+  float a;
+  float b;
+};
+
+bool operator!=(const Pair& x, const Pair& y)
+{
+  return x.a != y.a || x.b != y.b;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// エンコードした値と要素の型の変換
+// 1, 2バイトの整数は下位ビットのみ残し、複素数, Pairの2つ目には符号を反転した値を入れる
+template <class T>
+struct Elem {
+  static T make(const REAL_TYPE x) { return (T)x; }
+  static double real(const T& x)   { return (double)x; }
+};
+
+template <class T>
+struct Elem_int {
+  static T make(const REAL_TYPE x) { return (T)(long long)x; }
+  static double real(const T& x)   { return (double)x; }
+};
+
+template <> struct Elem<signed char>   : public Elem_int<signed char> {};
+template <> struct Elem<unsigned char> : public Elem_int<unsigned char> {};
+template <> struct Elem<short>         : public Elem_int<short> {};
+
+template <class F>
+struct Elem< std::complex<F> > {
+  static std::complex<F> make(const REAL_TYPE x) { return std::complex<F>((F)x, (F)-x); }
+  static double real(const std::complex<F>& x)   { return (double)x.real(); }
+};
+
+template <>
+struct Elem<Pair> {
+  static Pair make(const REAL_TYPE x) { Pair p; p.a = (float)x; p.b = (float)-x; return p; }
+  static double real(const Pair& x)   { return (double)x.a; }
+};
+
+
+// ベクトル配列の成分の並び (aosモード)
+static int vec_layout = LAYOUT_SOA;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 成分の並びに応じた配列上の位置
+size_t vidx(const int i, const int j, const int k, const int l,
+            const int NI, const int NJ, const int NK, const int gc, const int nc)
+{
+  if ( vec_layout == LAYOUT_AOS ) return (size_t)_IDX_S3D(i,j,k,NI,NJ,gc) * nc + l;
+  return _IDX_V3D(i,j,k,l,NI,NJ,NK,gc);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 内点に値をセット、袖は-1
+template <class T>
+void setup(T* v,
+           const int* sz,
+           const int gc,
+           const int nc,
+           const int* G_size,
+           const int* head)
+{
+  int NI = sz[0];
+  int NJ = sz[1];
+  int NK = sz[2];
+  size_t len = (size_t)(NI+2*gc) * (NJ+2*gc) * (NK+2*gc) * nc;
+
+  for (size_t i=0; i<len; i++) v[i] = Elem<T>::make(-1);
+
+  for (int l=0; l<nc; l++) {
+  for (int k=0; k<NK; k++) {
+  for (int j=0; j<NJ; j++) {
+  for (int i=0; i<NI; i++) {
+    v[vidx(i,j,k,l,NI,NJ,NK,gc,nc)] = Elem<T>::make(encode(G_size, head[0]+i, head[1]+j, head[2]+k, l));
+  }}}}
+}
+
+
+// 袖通信の転送精度 (float, bf16モード)
+static int trans_prec = PREC_FULL;
+
+
+// 袖を受信する方向 (maskモード)
+static unsigned dir_mask = DIR_ALL;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 転送精度に丸めた値
+template <class T>
+T roundPrec(const T x)
+{
+  if ( trans_prec == PREC_FLOAT ) return (T)(float)x;
+  if ( trans_prec == PREC_BF16 )  return (T)(float)CB_bf16((float)x);
+  return x;
+}
+
+// 精度を落とした転送の対象外
+template <class F>
+std::complex<F> roundPrec(const std::complex<F> x) { return x; }
+
+Pair roundPrec(const Pair x) { return x; }
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 受信領域の値を確認
+// st, edを与えた場合は、その範囲と交わる部分のみ
+template <class T>
+int check(BrickComm& CM,
+          const T* v,
+          const int* sz,
+          const int gc,
+          const int gc_comm,
+          const int nc,
+          const int* G_size,
+          const int* head,
+          const int myRank,
+          const int* st=NULL,
+          const int* ed=NULL)
+{
+  int NI = sz[0];
+  int NJ = sz[1];
+  int NK = sz[2];
+  int err = 0;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    CM.setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    if ( st && ed ) {
+      for (int m=0; m<3; m++) {
+        if ( b.r_st[m] < st[m] ) b.r_st[m] = st[m];
+        if ( b.r_ed[m] > ed[m] ) b.r_ed[m] = ed[m];
+      }
+    }
+
+    for (int l=0; l<nc; l++) {
+    for (int k=b.r_st[2]; k<b.r_ed[2]; k++) {
+    for (int j=b.r_st[1]; j<b.r_ed[1]; j++) {
+    for (int i=b.r_st[0]; i<b.r_ed[0]; i++) {
+      T ref = roundPrec(Elem<T>::make(encode(G_size, head[0]+i, head[1]+j, head[2]+k, l)));
+      T val = v[vidx(i,j,k,l,NI,NJ,NK,gc,nc)];
+      if ( val != ref ) {
+        if ( err < 10 ) {
+          printf("[%d] dir=%2d (%3d %3d %3d %d) val=%.0f ref=%.0f\n",
+                 myRank, dir, i, j, k, l, Elem<T>::real(val), Elem<T>::real(ref));
+        }
+        err++;
+      }
+    }}}}
+  }
+
+  return err;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cellの袖全体（辺・点を含む）を確認
+// 点のある側の全ての軸で隣接ランクがあれば、その点は隣接ランクの内点
+template <class T>
+int check_shell(const T* v,
+                const int* sz,
+                const int gc,
+                const int nc,
+                const int* G_size,
+                const int* head,
+                const int* nID,
+                const int myRank)
+{
+  int NI = sz[0];
+  int NJ = sz[1];
+  int NK = sz[2];
+  int err = 0;
+
+  for (int l=0; l<nc; l++) {
+  for (int k=-gc; k<NK+gc; k++) {
+  for (int j=-gc; j<NJ+gc; j++) {
+  for (int i=-gc; i<NI+gc; i++) {
+    int p[3] = {i, j, k};
+    bool halo = false;
+    bool valid = true;
+    for (int m=0; m<3; m++) {
+      if ( p[m] < 0 )        { halo = true; if ( nID[2*m]   < 0 ) valid = false; }
+      if ( p[m] >= sz[m] )   { halo = true; if ( nID[2*m+1] < 0 ) valid = false; }
+    }
+    if ( !halo || !valid ) continue;
+
+    T ref = (T)encode(G_size, head[0]+i, head[1]+j, head[2]+k, l);
+    T val = v[vidx(i,j,k,l,NI,NJ,NK,gc,nc)];
+    if ( val != ref ) {
+      if ( err < 10 ) {
+        printf("[%d] shell (%3d %3d %3d %d) val=%.0f ref=%.0f\n",
+               myRank, i, j, k, l, (double)val, (double)ref);
+      }
+      err++;
+    }
+  }}}}
+
+  return err;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 計算とオーバーラップする袖通信
+// 境界領域を返すたびに、gc広げた範囲の袖を確認する
+int exchange_overlap(BrickComm& CM,
+                     REAL_TYPE* v,
+                     const int* sz,
+                     const int gc,
+                     const int nc,
+                     const int* G_size,
+                     const int* head,
+                     const int myRank)
+{
+  int NI = sz[0];
+  int NJ = sz[1];
+  int NK = sz[2];
+  int err = 0;
+
+  CommOverlap ov;
+  if ( !CM.Comm_overlap(&ov, v, gc, nc) ) return 1;
+
+  // 内点を覆う回数
+  int* cover = new int[(size_t)NI*NJ*NK];
+  for (size_t i=0; i<(size_t)NI*NJ*NK; i++) cover[i] = 0;
+
+  for (int k=ov.ist[2]; k<ov.ied[2]; k++) {
+  for (int j=ov.ist[1]; j<ov.ied[1]; j++) {
+  for (int i=ov.ist[0]; i<ov.ied[0]; i++) {
+    cover[((size_t)k*NJ + j)*NI + i]++;
+  }}}
+
+  int f;
+  while ( true ) {
+    if ( !CM.Comm_overlap_next(&ov, v, &f) ) {
+      err++;
+      break;
+    }
+    if ( f < 0 ) break;
+
+    int st[3], ed[3];
+    for (int m=0; m<3; m++) {
+      st[m] = ov.b_st[f][m] - gc;
+      ed[m] = ov.b_ed[f][m] + gc;
+    }
+    err += check(CM, v, sz, gc, gc, nc, G_size, head, myRank, st, ed);
+
+    for (int k=ov.b_st[f][2]; k<ov.b_ed[f][2]; k++) {
+    for (int j=ov.b_st[f][1]; j<ov.b_ed[f][1]; j++) {
+    for (int i=ov.b_st[f][0]; i<ov.b_ed[f][0]; i++) {
+      cover[((size_t)k*NJ + j)*NI + i]++;
+    }}}
+  }
+
+  for (size_t i=0; i<(size_t)NI*NJ*NK; i++) {
+    if ( cover[i] != 1 ) {
+      if ( err < 10 ) printf("[%d] cover=%d at %ld\n", myRank, cover[i], (long)i);
+      err++;
+    }
+  }
+
+  delete [] cover;
+
+  return err;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 7点ステンシルの平滑化 [st, ed)を更新
+void smooth(REAL_TYPE* v,
+            REAL_TYPE* w,
+            const int* sz,
+            const int gc,
+            const int nc,
+            const int* st,
+            const int* ed)
+{
+  int NI = sz[0];
+  int NJ = sz[1];
+  int NK = sz[2];
+
+  for (int l=0; l<nc; l++) {
+    for (int k=st[2]; k<ed[2]; k++) {
+    for (int j=st[1]; j<ed[1]; j++) {
+    for (int i=st[0]; i<ed[0]; i++) {
+      w[_IDX_V3D(i,j,k,l,NI,NJ,NK,gc)] = ( 2.0 * v[_IDX_V3D(i,  j,  k,  l,NI,NJ,NK,gc)]
+                                             + v[_IDX_V3D(i-1,j,  k,  l,NI,NJ,NK,gc)]
+                                             + v[_IDX_V3D(i+1,j,  k,  l,NI,NJ,NK,gc)]
+                                             + v[_IDX_V3D(i,  j-1,k,  l,NI,NJ,NK,gc)]
+                                             + v[_IDX_V3D(i,  j+1,k,  l,NI,NJ,NK,gc)]
+                                             + v[_IDX_V3D(i,  j,  k-1,l,NI,NJ,NK,gc)]
+                                             + v[_IDX_V3D(i,  j,  k+1,l,NI,NJ,NK,gc)] ) * 0.125;
+    }}}
+
+    for (int k=st[2]; k<ed[2]; k++) {
+    for (int j=st[1]; j<ed[1]; j++) {
+    for (int i=st[0]; i<ed[0]; i++) {
+      v[_IDX_V3D(i,j,k,l,NI,NJ,NK,gc)] = w[_IDX_V3D(i,j,k,l,NI,NJ,NK,gc)];
+    }}}
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 深い袖による通信回避
+// gc層の袖をgcステップに1回通信して進めた値が、毎ステップ1層通信して
+// 進めた値と内点で一致し、通信回数が1/gcとなるかを確認する
+int exchange_deep(BrickComm& CM,
+                  REAL_TYPE* v,
+                  const int* sz,
+                  const int gc,
+                  const int nc,
+                  const char* grid,
+                  const int* G_size,
+                  const int* head,
+                  const int myRank)
+{
+  CommDeep dp;
+
+  // nodeは対象外
+  if ( !strcasecmp(grid, "node") ) return CM.setCommDeep(&dp, 1, gc, nc) ? 1 : 0;
+
+  if ( !CM.setCommDeep(&dp, 1, gc, nc) ) return 1;
+
+  int NI = sz[0];
+  int NJ = sz[1];
+  int NK = sz[2];
+  size_t len = (size_t)(NI+2*gc) * (NJ+2*gc) * (NK+2*gc) * nc;
+
+  REAL_TYPE* ref = new REAL_TYPE[len];
+  REAL_TYPE* w   = new REAL_TYPE[len];
+
+  // 線形な値は平滑化で変わらないので、2乗して剰余をとる
+  for (int l=0; l<nc; l++) {
+  for (int k=0; k<NK; k++) {
+  for (int j=0; j<NJ; j++) {
+  for (int i=0; i<NI; i++) {
+    size_t m = _IDX_V3D(i,j,k,l,NI,NJ,NK,gc);
+    v[m] = fmod(v[m] * v[m], 1000.0);
+  }}}}
+
+  for (size_t m=0; m<len; m++) ref[m] = v[m];
+
+  MPI_Request req[NOFACE*2];
+  int in_st[3] = {0, 0, 0};
+  const int nstep = 3 * gc + 1;
+  int err = 0;
+
+  for (int step=0; step<nstep; step++) {
+    bool ret = CM.Comm_deep(&dp, v);
+    if ( ret ) smooth(v, w, sz, gc, nc, dp.st, dp.ed);
+
+    if ( nc == 1 ) ret = ret && CM.Comm_S_cell(ref, 1, req) && CM.Comm_S_wait_cell(ref, 1, req);
+    else           ret = ret && CM.Comm_V_cell(ref, 1, req) && CM.Comm_V_wait_cell(ref, 1, req);
+
+    if ( !ret ) {
+      printf("[%d] exchange failed : deep step=%d\n", myRank, step);
+      err++;
+      break;
+    }
+    smooth(ref, w, sz, gc, nc, in_st, sz);
+  }
+
+  for (int l=0; l<nc; l++) {
+  for (int k=0; k<NK; k++) {
+  for (int j=0; j<NJ; j++) {
+  for (int i=0; i<NI; i++) {
+    size_t m = _IDX_V3D(i,j,k,l,NI,NJ,NK,gc);
+    if ( v[m] != ref[m] ) {
+      if ( err < 10 ) printf("[%d] deep (%d %d %d %d) : %e != %e\n", myRank, i, j, k, l, v[m], ref[m]);
+      err++;
+    }
+  }}}}
+
+  if ( dp.n_comm != (nstep + gc - 1) / gc ) {
+    printf("[%d] deep exchanged %d times in %d steps\n", myRank, dp.n_comm, nstep);
+    err++;
+  }
+
+  delete [] ref;
+  delete [] w;
+
+  return err;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// モードに応じて袖通信
+template <class T>
+bool exchange(BrickComm& CM,
+              T* v,
+              const int gc_comm,
+              const int nc,
+              const char* grid,
+              const char* mode,
+              MPI_Request* req)
+{
+  bool node = !strcasecmp(grid, "node");
+
+  // 派生データ型による直接送受信, K面の平面による直接送受信
+  int cm = COMM_PACK;
+  if      ( !strncasecmp(mode, "dtype", 5) ) cm = COMM_DTYPE;
+  else if ( !strncasecmp(mode, "kface", 5) ) cm = COMM_KFACE;
+  else if ( !strcasecmp(mode, "sweep") )     cm = COMM_SWEEP;
+  else if ( !strcasecmp(mode, "neighbor") )  cm = COMM_NEIGHBOR;
+  else if ( !strcasecmp(mode, "rma") )       cm = COMM_RMA;
+  else if ( !strcasecmp(mode, "shm") )       cm = COMM_SHM;
+  else if ( !strncasecmp(mode, "zip", 3) )   cm = COMM_ZIP;
+
+  // COMM_SWEEPはcellのみ、nodeはエラーとなることを確認してCOMM_PACKで通信
+  if ( cm == COMM_SWEEP && node ) {
+    if ( CM.setCommMode(cm) ) return false;
+    cm = COMM_PACK;
+  }
+  if ( !CM.setCommMode(cm) ) return false;
+
+  if ( !strcasecmp(mode, "legacy") || !strcasecmp(mode, "dtype") || !strcasecmp(mode, "kface") ||
+       !strcasecmp(mode, "progress") || !strcasecmp(mode, "kface_progress") || !strcasecmp(mode, "sweep") || !strcasecmp(mode, "neighbor") ||
+       !strcasecmp(mode, "rma") || !strcasecmp(mode, "shm") || !strcasecmp(mode, "thread") ||
+       !strcasecmp(mode, "arena") || !strcasecmp(mode, "zip") || !strcasecmp(mode, "zip_progress") ||
+       !strcasecmp(mode, "float") || !strcasecmp(mode, "bf16") ) {
+    int p = trans_prec;
+    unsigned m = dir_mask;
+    bool ret;
+    if      ( nc == 1 ) ret = node ? CM.Comm_S_node(v, gc_comm, req, p, m) : CM.Comm_S_cell(v, gc_comm, req, p, m);
+    else if ( nc == 3 ) ret = node ? CM.Comm_V_node(v, gc_comm, req, p, m) : CM.Comm_V_cell(v, gc_comm, req, p, m);
+    else                ret = node ? CM.Comm_N_node(v, gc_comm, nc, req, p, m) : CM.Comm_N_cell(v, gc_comm, nc, req, p, m);
+    if ( !ret ) return false;
+
+    // 到着済みの方向を途中でunpack (kface_progressはK面の送信を途中で開始、
+    // zip_progressは途中で完了した受信のバイト数で展開)
+    if ( !strcasecmp(mode, "progress") || !strcasecmp(mode, "kface_progress") ||
+         !strcasecmp(mode, "zip_progress") ) {
+      for (int n=0; n<100; n++) {
+        if ( !CM.progress(v, gc_comm, nc, req, p, m) ) return false;
+      }
+    }
+
+    // 計算の代わりに待つ間、通信スレッドが通信を進める
+    if ( !strcasecmp(mode, "thread") ) usleep(1000);
+
+    if ( nc == 1 ) return node ? CM.Comm_S_wait_node(v, gc_comm, req, p, m) : CM.Comm_S_wait_cell(v, gc_comm, req, p, m);
+    if ( nc == 3 ) return node ? CM.Comm_V_wait_node(v, gc_comm, req, p, m) : CM.Comm_V_wait_cell(v, gc_comm, req, p, m);
+    return node ? CM.Comm_N_wait_node(v, gc_comm, nc, req, p, m) : CM.Comm_N_wait_cell(v, gc_comm, nc, req, p, m);
+  }
+  else if ( !strcasecmp(mode, "plan") || !strcasecmp(mode, "dtype_plan") || !strcasecmp(mode, "kface_plan") ) {
+    CommPlan pl;
+    if ( !CM.setCommPlan(&pl, v, gc_comm, nc) ) return false;
+
+    // 同じプランで繰り返し通信
+    for (int n=0; n<3; n++) {
+      if ( !CM.Comm_plan(&pl, v) ) return false;
+      if ( !CM.Comm_plan_wait(&pl, v) ) return false;
+    }
+    return true;
+  }
+
+  printf("Mode error >> %s\n", mode);
+  return false;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 要素の型Tの配列を、comm_modeごとに成分数1-3で通信 (typesモード)
+// init()のバッファに収まらない成分数は通信できないこと（プランは専用のバッファを確保する）
+template <class T>
+int exchange_types(BrickComm& CM,
+                   const T* t,
+                   const char* name,
+                   const int* sz,
+                   const int gc,
+                   const int buf_compo,
+                   const char* grid,
+                   const int* G_size,
+                   const int* head,
+                   const int myRank,
+                   MPI_Request* req)
+{
+  const char* sub[] = {"legacy", "dtype", "kface", "neighbor", "plan"};
+  size_t len = (size_t)(sz[0]+2*gc) * (sz[1]+2*gc) * (sz[2]+2*gc) * 3;
+  T* v = new T[len];
+  int err = 0;
+
+  for (int s=0; s<5; s++) {
+    for (int nc=1; nc<=3; nc++) {
+      setup(v, sz, gc, nc, G_size, head);
+
+      if ( strcasecmp(sub[s], "plan") && sizeof(T) * nc > sizeof(double) * buf_compo ) {
+        if ( exchange(CM, v, gc, nc, grid, sub[s], req) ) {
+          printf("[%d] buffer overrun accepted : types %s %s nc=%d\n", myRank, name, sub[s], nc);
+          err++;
+        }
+        continue;
+      }
+
+      if ( !exchange(CM, v, gc, nc, grid, sub[s], req) ) {
+        printf("[%d] exchange failed : types %s %s nc=%d\n", myRank, name, sub[s], nc);
+        err++;
+        continue;
+      }
+      err += check(CM, v, sz, gc, gc, nc, G_size, head, myRank);
+    }
+  }
+
+  delete [] v;
+  return err;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 分割数divと周期境界prdの領域で、comm_modeごとに成分数1-3を通信 (periodicモード)
+int exchange_periodic(const int* G_size,
+                      const int gc,
+                      const char* grid,
+                      const int* div,
+                      const int* prd,
+                      MPI_Comm comm,
+                      const int np,
+                      const int myRank)
+{
+  std::string grd_str = !strcasecmp(grid, "node") ? "node" : "cell";
+
+  SubDomain D;
+  D.setPeriodic(prd);
+  if ( !D.setSubDomain((int*)G_size, gc, np, myRank, 0, MPI_COMM_WORLD, grd_str, "Cindex") ||
+       !D.setDivision(div) ||
+       !D.findOptimalDivision() ||
+       !D.createRankTable() ) {
+    printf("[%d] division failed : periodic %d %d %d\n", myRank, div[0], div[1], div[2]);
+    return 1;
+  }
+
+  int lsz[3], head[3], nID[NOFACE];
+  D.getLocalSize(lsz);
+  D.getLocalHead(head);
+  D.getCommTable(nID);
+
+  BrickComm CM;
+  if ( !CM.setBrickComm(lsz, gc, comm, nID, grd_str) || !CM.init(5) ) return 1;
+
+  for (int m=0; m<3; m++) {
+    period[m] = prd[m] ? ( (grd_str == "node") ? G_size[m]-1 : G_size[m] ) : 0;
+  }
+
+  const char* sub[] = {"legacy", "plan", "dtype", "dtype_plan", "kface", "kface_plan",
+                       "sweep", "neighbor", "rma", "shm", "zip", "progress"};
+  size_t len = (size_t)(lsz[0]+2*gc) * (lsz[1]+2*gc) * (lsz[2]+2*gc) * 3;
+  REAL_TYPE* v = new REAL_TYPE[len];
+  MPI_Request req[NOFACE*2];
+  int err = 0;
+
+  for (int s=0; s<12; s++) {
+    for (int nc=1; nc<=3; nc++) {
+      setup(v, lsz, gc, nc, G_size, head);
+
+      if ( !exchange(CM, v, gc, nc, grid, sub[s], req) ) {
+        printf("[%d] exchange failed : periodic %d %d %d %s nc=%d\n", myRank, div[0], div[1], div[2], sub[s], nc);
+        err++;
+        continue;
+      }
+      err += check(CM, v, lsz, gc, gc, nc, G_size, head, myRank);
+    }
+  }
+
+  for (int m=0; m<3; m++) period[m] = 0;
+
+  if ( !CM.freeCommResources() ) err++;
+
+  delete [] v;
+  return err;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// 袖を受信する方向を選び、comm_modeごとに成分数1-3を通信 (maskモード)
+// maskの方向の受信領域は隣接ランクの内点の値、その他は通信前の値のままであること
+int exchange_mask(BrickComm& CM,
+                  REAL_TYPE* v,
+                  const int* sz,
+                  const int gc,
+                  const char* grid,
+                  const int* G_size,
+                  const int* head,
+                  const int myRank,
+                  MPI_Request* req)
+{
+  // 軸ごと、片側のみ、面のみ、辺・点のみ、面と1つの点
+  const unsigned mask[] = {DIR_X, DIR_Y, DIR_Z, DIR_I_MINUS, DIR_J_PLUS | DIR_K_MINUS,
+                           DIR_FACE, DIR_EDGE | DIR_CORNER, DIR_FACE | (1u << (NOFACE-1))};
+  const char* sub[] = {"legacy", "dtype", "neighbor", "progress", "float"};
+  int NI = sz[0];
+  int NJ = sz[1];
+  int NK = sz[2];
+  size_t len = (size_t)(NI+2*gc) * (NJ+2*gc) * (NK+2*gc) * 3;
+  REAL_TYPE* w = new REAL_TYPE[len];
+  int err = 0;
+
+  CommBox box[NOFACE];
+  for (int dir=0; dir<NOFACE; dir++) CM.setCommBox(dir, gc, &box[dir]);
+
+  for (int c=0; c<8; c++) {
+    for (int s=0; s<5; s++) {
+      for (int nc=1; nc<=3; nc++) {
+        setup(v, sz, gc, nc, G_size, head);
+        memcpy(w, v, sizeof(REAL_TYPE) * len);
+
+        trans_prec = !strcasecmp(sub[s], "float") ? PREC_FLOAT : PREC_FULL;
+        dir_mask = mask[c];
+
+        bool ret = exchange(CM, v, gc, nc, grid, sub[s], req);
+
+        dir_mask = DIR_ALL;
+
+        if ( !ret ) {
+          printf("[%d] exchange failed : mask %#x %s nc=%d\n", myRank, mask[c], sub[s], nc);
+          err++;
+          trans_prec = PREC_FULL;
+          continue;
+        }
+
+        for (int l=0; l<nc; l++) {
+        for (int k=-gc; k<NK+gc; k++) {
+        for (int j=-gc; j<NJ+gc; j++) {
+        for (int i=-gc; i<NI+gc; i++) {
+          bool recv = false;
+          for (int dir=0; dir<NOFACE; dir++) {
+            const CommBox* b = &box[dir];
+            if ( !(mask[c] & (1u << dir)) || b->nID < 0 ) continue;
+            if ( i >= b->r_st[0] && i < b->r_ed[0] &&
+                 j >= b->r_st[1] && j < b->r_ed[1] &&
+                 k >= b->r_st[2] && k < b->r_ed[2] ) recv = true;
+          }
+
+          size_t m = vidx(i,j,k,l,NI,NJ,NK,gc,nc);
+          REAL_TYPE ref = recv ? roundPrec(encode(G_size, head[0]+i, head[1]+j, head[2]+k, l)) : w[m];
+          if ( v[m] != ref ) {
+            if ( err < 10 ) {
+              printf("[%d] mask %#x %s (%3d %3d %3d %d) val=%.0f ref=%.0f\n",
+                     myRank, mask[c], sub[s], i, j, k, l, v[m], ref);
+            }
+            err++;
+          }
+        }}}}
+
+        trans_prec = PREC_FULL;
+      }
+    }
+  }
+
+  delete [] w;
+  return err;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char * argv[])
+{
+  int np=0;
+  int myRank=-1;
+
+  // 通信スレッドはMPI関数を呼ぶ
+  if ( argc == 7 && !strcasecmp(argv[6], "thread") ) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+  }
+  else {
+    MPI_Init(&argc, &argv);
+  }
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+  MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
+
+  if ( argc != 7 ) {
+    Hostonly_ {
+      printf("\t$ mpirun -np N ./commcheck nx ny nz gc grid mode\n");
+      printf("\tgrid; grid type (node, cell).\n");
+      printf("\tmode; exchange mode (legacy, plan, dtype, dtype_plan, kface, kface_plan, kface_progress, zip_progress, field, overlap, progress, sweep, multi, neighbor, rma, shm, thread, arena, zip, float, bf16, deep, simd, ncompo, aos, omp, threshold, types, periodic, mask).\n");
+    }
+    MPI_Finalize();
+    return 1;
+  }
+
+  int G_size[3];
+  G_size[0] = atoi(argv[1]);
+  G_size[1] = atoi(argv[2]);
+  G_size[2] = atoi(argv[3]);
+  int gc    = atoi(argv[4]);
+  char* grid = argv[5];
+  char* mode = argv[6];
+
+  std::string grd_str = !strcasecmp(grid, "node") ? "node" : "cell";
+
+  SubDomain D;
+  if ( !D.setSubDomain(G_size, gc, np, myRank, 0, MPI_COMM_WORLD, grd_str, "Cindex") ||
+       !D.findOptimalDivision() ||
+       !D.createRankTable() ) {
+    MPI_Abort(MPI_COMM_WORLD, -1);
+  }
+
+  int lsz[3], head[3], nID[NOFACE];
+  D.getLocalSize(lsz);
+  D.getLocalHead(head);
+  D.getCommTable(nID);
+
+  // 集約通信では scalar(double) + vector(double) + scalar(float) の5成分
+  // MPI_COMM_WORLDの通信と混ざらないこと
+  MPI_Comm comm;
+  MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+
+  BrickComm CM;
+  if ( !CM.setBrickComm(lsz, gc, comm, nID, grd_str) ) {
+    MPI_Abort(MPI_COMM_WORLD, -1);
+  }
+
+  // MPI_Alloc_mem, huge pageで確保し、大きい成分数で確保し直す
+  if ( !strcasecmp(mode, "arena") ) {
+    if ( !CM.setBufOption(BUF_MPIMEM | BUF_HUGEPAGE) || !CM.init(1) ) {
+      MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+  }
+
+  if ( !CM.init(5) ) {
+    MPI_Abort(MPI_COMM_WORLD, -1);
+  }
+
+  if ( !strcasecmp(mode, "thread") && !CM.startProgressThread() ) {
+    MPI_Abort(MPI_COMM_WORLD, -1);
+  }
+
+  // 精度を落とした転送
+  if ( !strcasecmp(mode, "float") ) trans_prec = PREC_FLOAT;
+  if ( !strcasecmp(mode, "bf16") )  trans_prec = PREC_BF16;
+
+  // 小さな面も、元より小さくなれば圧縮
+  if ( !strncasecmp(mode, "zip", 3) && !CM.setCompress(0, 1.0) ) {
+    MPI_Abort(MPI_COMM_WORLD, -1);
+  }
+
+  MPI_Request req[NOFACE*2];
+  size_t len = (size_t)(lsz[0]+2*gc) * (lsz[1]+2*gc) * (lsz[2]+2*gc);
+  REAL_TYPE* S = new REAL_TYPE[len];
+  REAL_TYPE* V = new REAL_TYPE[len*3];
+
+  int err = 0;
+
+  if ( !strcasecmp(mode, "field") ) {
+    // 型の異なる配列を集約して通信
+    float* F = new float[len];
+    setup(S, lsz, gc, 1, G_size, head);
+    setup(V, lsz, gc, 3, G_size, head);
+    setup(F, lsz, gc, 1, G_size, head);
+
+    CommFieldList fl;
+    fl.add(S);
+    fl.add(F);
+    fl.add(V, 3);
+
+    if ( !CM.Comm_fields(&fl, gc, req) || !CM.Comm_fields_wait(&fl, gc, req) ) {
+      printf("[%d] exchange failed : field\n", myRank);
+      err++;
+    }
+    else {
+      err += check(CM, S, lsz, gc, gc, 1, G_size, head, myRank);
+      err += check(CM, V, lsz, gc, gc, 3, G_size, head, myRank);
+      err += check(CM, F, lsz, gc, gc, 1, G_size, head, myRank);
+    }
+    delete [] F;
+  }
+
+  if ( !strcasecmp(mode, "multi") ) {
+    // 識別番号の異なる2つのプランを同時に通信
+    // 開始の順をランクで入れ替えても、タグで区別される
+    setup(S, lsz, gc, 1, G_size, head);
+    setup(V, lsz, gc, 3, G_size, head);
+
+    CommPlan ps, pv;
+    bool ret = CM.setCommTag(1) && CM.setCommPlan(&ps, S, gc, 1) &&
+               CM.setCommTag(2) && CM.setCommPlan(&pv, V, gc, 3) &&
+               CM.setCommTag(0);
+
+    if ( ret ) {
+      if ( myRank % 2 == 0 ) ret = CM.Comm_plan(&ps, S) && CM.Comm_plan(&pv, V);
+      else                   ret = CM.Comm_plan(&pv, V) && CM.Comm_plan(&ps, S);
+    }
+    ret = ret && CM.Comm_plan_wait(&pv, V) && CM.Comm_plan_wait(&ps, S);
+
+    if ( !ret ) {
+      printf("[%d] exchange failed : multi\n", myRank);
+      err++;
+    }
+    else {
+      err += check(CM, S, lsz, gc, gc, 1, G_size, head, myRank);
+      err += check(CM, V, lsz, gc, gc, 3, G_size, head, myRank);
+    }
+
+    // バッファを共有する通信は、waitの前に次を開始できない
+    MPI_Request req2[NOFACE*2];
+    bool cell = !strcasecmp(grid, "cell");
+    if ( !( cell ? CM.Comm_S_cell(S, gc, req) : CM.Comm_S_node(S, gc, req) ) ) err++;
+    if (    cell ? CM.Comm_V_cell(V, gc, req2) : CM.Comm_V_node(V, gc, req2) ) err++;
+    if ( !( cell ? CM.Comm_S_wait_cell(S, gc, req) : CM.Comm_S_wait_node(S, gc, req) ) ) err++;
+
+    // 格子の種類と異なるエントリはエラー
+    if ( cell ? CM.Comm_S_node(S, gc, req) : CM.Comm_S_cell(S, gc, req) ) err++;
+    if ( cell ? CM.Comm_N_node(V, gc, 3, req) : CM.Comm_N_cell(V, gc, 3, req) ) err++;
+  }
+
+  if ( !strcasecmp(mode, "simd") ) {
+    // 使える命令セットごとに、通信面数を変えてdouble, floatの配列を通信
+    // pack_Boxes, unpack_Boxesが行ごとにpack_Rows, unpack_Rowsを呼ぶので、
+    // 1スレッド（逐次）と3スレッド（全boxを1つの並列領域）の両方で確認する
+    int max_lv = BrickComm::getSimdLevel();
+    float* F = new float[len*3];
+
+    for (int nt=1; nt<=3; nt+=2) {
+#ifdef _OPENMP
+      omp_set_num_threads(nt);
+#endif
+      if ( !BrickComm::setParallelThreshold( (nt == 1) ? (1L << 40) : 0 ) ) err++;
+
+      for (int lv=SIMD_SCALAR; lv<=max_lv; lv++) {
+        if ( !BrickComm::setSimdLevel(lv) ) {
+          err++;
+          break;
+        }
+
+        for (int g=1; g<=gc; g++) {
+          for (int nc=1; nc<=3; nc+=2) {
+            REAL_TYPE* v = (nc == 1) ? S : V;
+            setup(v, lsz, gc, nc, G_size, head);
+            setup(F, lsz, gc, nc, G_size, head);
+
+            if ( !exchange(CM, v, g, nc, grid, "legacy", req) || !exchange(CM, F, g, nc, grid, "legacy", req) ) {
+              printf("[%d] exchange failed : threads=%d simd=%d gc=%d nc=%d\n", myRank, nt, lv, g, nc);
+              err++;
+              continue;
+            }
+            err += check(CM, v, lsz, gc, g, nc, G_size, head, myRank);
+            err += check(CM, F, lsz, gc, g, nc, G_size, head, myRank);
+          }
+        }
+      }
+    }
+    delete [] F;
+  }
+
+  if ( !strcasecmp(mode, "ncompo") ) {
+    // 成分数2, 4, 5の配列を、comm_modeごとに1回の通信で送受信
+    const char* sub[] = {"legacy", "dtype", "kface", "sweep", "neighbor", "rma", "shm", "zip", "float"};
+    REAL_TYPE* N = new REAL_TYPE[len*5];
+
+    for (int s=0; s<9; s++) {
+      trans_prec = !strcasecmp(sub[s], "float") ? PREC_FLOAT : PREC_FULL;
+
+      for (int nc=2; nc<=5; nc++) {
+        if ( nc == 3 ) continue;
+        setup(N, lsz, gc, nc, G_size, head);
+
+        if ( !exchange(CM, N, gc, nc, grid, sub[s], req) ) {
+          printf("[%d] exchange failed : ncompo %s nc=%d\n", myRank, sub[s], nc);
+          err++;
+          continue;
+        }
+        err += check(CM, N, lsz, gc, gc, nc, G_size, head, myRank);
+      }
+    }
+    trans_prec = PREC_FULL;
+
+    // init()で与えた成分数を超える
+    if ( CM.Comm_N_cell(N, gc, 6, req) ) err++;
+
+    delete [] N;
+  }
+
+  if ( !strcasecmp(mode, "aos") ) {
+    // 成分が最内の配列を、comm_modeごとに通信
+    const char* sub[] = {"legacy", "dtype", "kface", "sweep", "neighbor", "rma", "shm", "zip", "float",
+                         "plan", "dtype_plan", "kface_plan"};
+    REAL_TYPE* N = new REAL_TYPE[len*5];
+
+    vec_layout = LAYOUT_AOS;
+    if ( !CM.setVecLayout(LAYOUT_AOS) ) err++;
+
+    for (int s=0; s<12; s++) {
+      trans_prec = !strcasecmp(sub[s], "float") ? PREC_FLOAT : PREC_FULL;
+
+      for (int nc=2; nc<=5; nc++) {
+        setup(N, lsz, gc, nc, G_size, head);
+
+        if ( !exchange(CM, N, gc, nc, grid, sub[s], req) ) {
+          printf("[%d] exchange failed : aos %s nc=%d\n", myRank, sub[s], nc);
+          err++;
+          continue;
+        }
+        err += check(CM, N, lsz, gc, gc, nc, G_size, head, myRank);
+      }
+    }
+    trans_prec = PREC_FULL;
+
+    // 作成後に並びを変えたプランは使えない
+    CommPlan pl;
+    if ( !CM.setCommMode(COMM_PACK) || !CM.setCommPlan(&pl, N, gc, 3) ) err++;
+    CM.setVecLayout(LAYOUT_SOA);
+    if ( CM.Comm_plan(&pl, N) ) err++;
+
+    vec_layout = LAYOUT_SOA;
+    delete [] N;
+  }
+
+  if ( !strcasecmp(mode, "omp") ) {
+    // 3スレッドで、全方向を1つの並列領域でpack, unpackする
+#ifdef _OPENMP
+    omp_set_num_threads(3);
+#endif
+    if ( !BrickComm::setParallelThreshold(0) ) err++;
+
+    const char* sub[] = {"legacy", "plan", "progress"};
+    REAL_TYPE* N = new REAL_TYPE[len*5];
+
+    for (int a=0; a<2; a++) {
+      vec_layout = ( a == 0 ) ? LAYOUT_SOA : LAYOUT_AOS;
+      if ( !CM.setVecLayout(vec_layout) ) err++;
+
+      for (int s=0; s<3; s++) {
+        for (int nc=1; nc<=5; nc++) {
+          setup(N, lsz, gc, nc, G_size, head);
+
+          if ( !exchange(CM, N, gc, nc, grid, sub[s], req) ) {
+            printf("[%d] exchange failed : omp %s nc=%d\n", myRank, sub[s], nc);
+            err++;
+            continue;
+          }
+          err += check(CM, N, lsz, gc, gc, nc, G_size, head, myRank);
+        }
+      }
+    }
+
+    vec_layout = LAYOUT_SOA;
+    CM.setVecLayout(LAYOUT_SOA);
+    delete [] N;
+  }
+
+  if ( !strcasecmp(mode, "threshold") ) {
+    // 環境変数で与えた閾値
+    const char* env = getenv("CB_PACK_PAR_BYTES");
+    if ( env && BrickComm::getParallelThreshold() != atol(env) ) err++;
+    if ( BrickComm::setParallelThreshold(-1) ) err++;
+
+#ifdef _OPENMP
+    omp_set_num_threads(3);
+#endif
+    // 常に並列、常に逐次
+    const long th[] = {0, 1L << 40};
+    const char* sub[] = {"legacy", "plan", "progress", "neighbor"};
+    REAL_TYPE* N = new REAL_TYPE[len*5];
+
+    for (int t=0; t<2; t++) {
+      if ( !BrickComm::setParallelThreshold(th[t]) ) err++;
+
+      for (int s=0; s<4; s++) {
+        for (int nc=1; nc<=5; nc++) {
+          setup(N, lsz, gc, nc, G_size, head);
+
+          if ( !exchange(CM, N, gc, nc, grid, sub[s], req) ) {
+            printf("[%d] exchange failed : threshold=%ld %s nc=%d\n", myRank, th[t], sub[s], nc);
+            err++;
+            continue;
+          }
+          err += check(CM, N, lsz, gc, gc, nc, G_size, head, myRank);
+        }
+      }
+    }
+    delete [] N;
+  }
+
+  if ( !strcasecmp(mode, "types") ) {
+    // 16バイトの型は、init()で与えた5成分のバッファに成分数2まで収まる
+    err += exchange_types(CM, (signed char*)NULL,   "int8",    lsz, gc, 5, grid, G_size, head, myRank, req);
+    err += exchange_types(CM, (unsigned char*)NULL, "uint8",   lsz, gc, 5, grid, G_size, head, myRank, req);
+    err += exchange_types(CM, (short*)NULL,         "int16",   lsz, gc, 5, grid, G_size, head, myRank, req);
+    err += exchange_types(CM, (CB_half*)NULL,       "half",    lsz, gc, 5, grid, G_size, head, myRank, req);
+    err += exchange_types(CM, (CB_bf16*)NULL,       "bf16",    lsz, gc, 5, grid, G_size, head, myRank, req);
+    err += exchange_types(CM, (std::complex<float>*)NULL,  "complex64",  lsz, gc, 5, grid, G_size, head, myRank, req);
+    err += exchange_types(CM, (std::complex<double>*)NULL, "complex128", lsz, gc, 5, grid, G_size, head, myRank, req);
+
+    // 大きさの合わない派生データ型は登録できない
+    if ( BrickComm::registerType<Pair>(MPI_FLOAT) ) err++;
+
+    // 整数の配列は精度を落とした転送に対応しない（開始、waitともエラー）
+    {
+      int* I = new int[len];
+      bool node = !strcasecmp(grid, "node");
+      if ( node ? CM.Comm_S_node(I, gc, req, PREC_FLOAT) : CM.Comm_S_cell(I, gc, req, PREC_FLOAT) ) err++;
+      if ( node ? CM.Comm_S_wait_node(I, gc, req, PREC_FLOAT) : CM.Comm_S_wait_cell(I, gc, req, PREC_FLOAT) ) err++;
+      delete [] I;
+    }
+
+    // 登録した利用者の型を、型の異なる配列と集約して通信
+    MPI_Datatype pt;
+    MPI_Type_contiguous(2, MPI_FLOAT, &pt);
+    MPI_Type_commit(&pt);
+    if ( !BrickComm::registerType<Pair>(pt) ) err++;
+
+    Pair* P = new Pair[len];
+    std::complex<double>* Z = new std::complex<double>[len];
+    setup(P, lsz, gc, 1, G_size, head);
+    setup(Z, lsz, gc, 1, G_size, head);
+    setup(S, lsz, gc, 1, G_size, head);
+
+    CommFieldList fl;
+    if ( !fl.add(P) || !fl.add(Z) || !fl.add(S) ||
+         !CM.Comm_fields(&fl, gc, req) || !CM.Comm_fields_wait(&fl, gc, req) ) {
+      printf("[%d] exchange failed : types field\n", myRank);
+      err++;
+    }
+    else {
+      err += check(CM, P, lsz, gc, gc, 1, G_size, head, myRank);
+      err += check(CM, Z, lsz, gc, gc, 1, G_size, head, myRank);
+      err += check(CM, S, lsz, gc, gc, 1, G_size, head, myRank);
+    }
+
+    delete [] P;
+    delete [] Z;
+    MPI_Type_free(&pt);
+  }
+
+  if ( !strcasecmp(mode, "periodic") ) {
+    // 最適分割で全軸が周期境界、X軸が分割数1で全軸が周期境界、
+    // Z軸が分割数1でX軸のみ周期境界でない（部分領域は袖の幅以上の大きさとする）
+    int a = ( np % 2 == 0 ) ? 2 : 1;
+    int div[3][3] = { {0, 0, 0}, {1, a, np/a}, {np/a, a, 1} };
+    const int prd[3][3] = { {1, 1, 1}, {1, 1, 1}, {0, 1, 1} };
+    D.getGlobalDivision(div[0]);
+
+    for (int c=0; c<3; c++) {
+      err += exchange_periodic(G_size, gc, grid, div[c], prd[c], comm, np, myRank);
+    }
+  }
+
+  if ( !strcasecmp(mode, "mask") ) {
+    err += exchange_mask(CM, V, lsz, gc, grid, G_size, head, myRank, req);
+  }
+
+  if ( !strcasecmp(mode, "zip_progress") ) {
+    // 圧縮しない大きさとし、progress()で完了した受信を展開しないことを確認
+    if ( !CM.setCompress(~(size_t)0, 1.0) ) err++;
+
+    for (int nc=1; nc<=3; nc+=2) {
+      REAL_TYPE* v = (nc == 1) ? S : V;
+      setup(v, lsz, gc, nc, G_size, head);
+
+      if ( !exchange(CM, v, gc, nc, grid, mode, req) ) {
+        printf("[%d] exchange failed : zip_progress raw nc=%d\n", myRank, nc);
+        err++;
+        continue;
+      }
+      err += check(CM, v, lsz, gc, gc, nc, G_size, head, myRank);
+    }
+
+    if ( !CM.setCompress(0, 1.0) ) err++;
+  }
+
+  // scalar, vector
+  for (int nc=1; nc<=3 && strcasecmp(mode, "field") && strcasecmp(mode, "multi") && strcasecmp(mode, "simd") &&
+                  strcasecmp(mode, "ncompo") && strcasecmp(mode, "aos") && strcasecmp(mode, "omp") &&
+                  strcasecmp(mode, "threshold") && strcasecmp(mode, "types") && strcasecmp(mode, "periodic") &&
+                  strcasecmp(mode, "mask"); nc+=2) {
+    REAL_TYPE* v = (nc == 1) ? S : V;
+    setup(v, lsz, gc, nc, G_size, head);
+
+    if ( !strcasecmp(mode, "overlap") ) {
+      err += exchange_overlap(CM, v, lsz, gc, nc, G_size, head, myRank);
+    }
+    else if ( !strcasecmp(mode, "deep") ) {
+      // 平滑化した値を比較するので、袖の値は確認しない
+      err += exchange_deep(CM, v, lsz, gc, nc, grid, G_size, head, myRank);
+      continue;
+    }
+    else if ( !exchange(CM, v, gc, nc, grid, mode, req) ) {
+      printf("[%d] exchange failed : nc=%d\n", myRank, nc);
+      err++;
+      continue;
+    }
+    err += check(CM, v, lsz, gc, gc, nc, G_size, head, myRank);
+
+    // sweepは斜め通信なしでも辺・点が埋まる、プランは作成できない
+    if ( !strcasecmp(mode, "sweep") && !strcasecmp(grid, "cell") ) {
+      err += check_shell(v, lsz, gc, nc, G_size, head, nID, myRank);
+
+      CommPlan pl;
+      if ( CM.setCommPlan(&pl, v, gc, nc) ) err++;
+    }
+  }
+
+  // 格子点番号の値は圧縮できる
+  if ( !strncasecmp(mode, "zip", 3) ) {
+    size_t raw, sent;
+    CM.getCompressStat(&raw, &sent);
+    if ( raw > 0 && sent >= raw ) {
+      printf("[%d] not compressed : %zu / %zu\n", myRank, sent, raw);
+      err++;
+    }
+  }
+
+  // トポロジー、受信ウィンドウは全ランクで解放する（解放前の設定し直しはエラー）
+  if ( !strcasecmp(mode, "neighbor") || !strcasecmp(mode, "rma") || !strcasecmp(mode, "shm") ) {
+    if ( CM.setBrickComm(lsz, gc, comm, nID, grd_str) ) err++;
+  }
+  if ( !CM.freeCommResources() ) err++;
+
+  int g_err = 0;
+  MPI_Allreduce(&err, &g_err, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  Hostonly_ printf("commcheck %s %s gc=%d : %s (%d)\n",
+                   grid, mode, gc, (g_err == 0) ? "PASS" : "FAIL", g_err);
+
+  delete [] S;
+  delete [] V;
+
+  CM.stopProgressThread();
+  MPI_Comm_free(&comm);
+  MPI_Finalize();
+
+  return (g_err == 0) ? 0 : 1;
+}
@@ -7,6 +7,22 @@ extern void initialize_(int* sz,
                         REAL_TYPE* q,
                         REAL_TYPE* w);
 
+extern void euler_explicit_box_(int* sz,
+                                int* gc,
+                                int* st,
+                                int* ed,
+                                REAL_TYPE* q,
+                                REAL_TYPE* w,
+                                REAL_TYPE* dh,
+                                REAL_TYPE* dt,
+                                REAL_TYPE* alpha,
+                                REAL_TYPE* res);
+
+extern void update_q_(int* sz,
+                      int* gc,
+                      REAL_TYPE* q,
+                      REAL_TYPE* w);
+
 extern void bc_(int* sz,
                 int* gc,
                 REAL_TYPE* q,
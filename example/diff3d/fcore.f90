@@ -94,6 +94,83 @@ return
 end subroutine euler_explicit
 
 
+!> ************************************
+!! @brief Euler explicit scheme for a sub-region
+!! @param [in]     sz      array length
+!! @param [in]     g       guide cell
+!! @param [in]     st      start index of the region
+!! @param [in]     ed      end index of the region
+!! @param [in]     q       variable
+!! @param [out]    w       work array to store the updated value
+!! @param [in]     dh      mesh width
+!! @param [in]     dt      time increment
+!! @param [in]     alpha   coefficient
+!! @param [out]    res     residual
+!! @note  qの更新はupdate_qで全領域をまとめて行う
+!<
+subroutine euler_explicit_box (sz, g, st, ed, q, w, dh, dt, alpha, res)
+implicit none
+integer                                                :: i, j, k, g
+integer, dimension(3)                                  :: sz, st, ed
+real, dimension(1-g:sz(1)+g, 1-g:sz(2)+g, 1-g:sz(3)+g) :: q, w
+real                                                   :: dh, dt, alpha, c, res, delta, q0
+
+c = alpha*dt/(dh*dh)
+res = 0.0
+
+!$OMP PARALLEL PRIVATE(q0, delta) REDUCTION(+:res)
+!$OMP DO SCHEDULE(static) COLLAPSE(2)
+do k=st(3), ed(3)
+do j=st(2), ed(2)
+do i=st(1), ed(1)
+  q0 = q(i,j,k)
+  delta = c * ( q(i-1,j,k) + q(i+1,j,k) &
+              + q(i,j-1,k) + q(i,j+1,k) &
+              + q(i,j,k-1) + q(i,j,k+1) &
+              - 6.0 * q0 )
+  w(i,j,k) = q0 + delta
+  res = res + delta * delta
+end do
+end do
+end do
+!$OMP END DO
+!$OMP END PARALLEL
+
+return
+end subroutine euler_explicit_box
+
+
+!> ************************************
+!! @brief Copy updated value
+!! @param [in]     sz      array length
+!! @param [in]     g       guide cell
+!! @param [out]    q       variable
+!! @param [in]     w       work array
+!<
+subroutine update_q (sz, g, q, w)
+implicit none
+integer                                                :: i, j, k, ix, jx, kx, g
+integer, dimension(3)                                  :: sz
+real, dimension(1-g:sz(1)+g, 1-g:sz(2)+g, 1-g:sz(3)+g) :: q, w
+
+ix = sz(1)
+jx = sz(2)
+kx = sz(3)
+
+!$OMP PARALLEL DO SCHEDULE(static) COLLAPSE(2)
+do k=1, kx
+do j=1, jx
+do i=1, ix
+  q(i,j,k) = w(i,j,k)
+end do
+end do
+end do
+!$OMP END PARALLEL DO
+
+return
+end subroutine update_q
+
+
 !> ************************************
 !! @brief Boundary condition
 !! @param [in]     sz   array length
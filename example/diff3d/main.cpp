@@ -34,6 +34,38 @@ REAL_TYPE* alloc_real(const size_t sz)
 }
 
 
+// @fn euler_box
+// @brief 部分領域のEuler陽解法
+// @param [in]     sz  サブドメインサイズ
+// @param [in]     gc  ガイドセル幅
+// @param [in]     st  開始インデクス (C表記)
+// @param [in]     ed  終了インデクス (C表記, 含まない)
+// @param [in]     q   変数
+// @param [out]    w   更新値
+// @param [in]     P   物理パラメータ
+// @retval 残差の2乗和
+REAL_TYPE euler_box(int* sz,
+                    int gc,
+                    const int* st,
+                    const int* ed,
+                    REAL_TYPE* q,
+                    REAL_TYPE* w,
+                    Phys_Param* P)
+{
+  // Fortranインデクスへ変換
+  int fs[3], fe[3];
+  for (int m=0; m<3; m++) {
+    fs[m] = st[m] + 1;
+    fe[m] = ed[m];
+  }
+
+  REAL_TYPE r = 0.0;
+  euler_explicit_box_(sz, &gc, fs, fe, q, w, &P->dh, &P->dt, &P->alpha, &r);
+
+  return r;
+}
+
+
 // @fn usage
 // @brief print usage
 void usage()
@@ -317,8 +349,8 @@ int main(int argc, char * argv[])
     return 0;
   }
 
-  // 通信バッファ確保  # of component = 1
-  if  ( !CM.init(1) ) {
+  // 通信バッファ確保  # of component = 2 (q, wの集約通信)
+  if  ( !CM.init(2) ) {
     stamped_printf("\tBrickComm initialize error.\n");
     return 0;
   }
@@ -328,22 +360,19 @@ int main(int argc, char * argv[])
   MPI_Request req[NOFACE*2];
   for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
 
+  // 計算とオーバーラップする通信の領域
+  CommOverlap ov;
+
   // initialization
   initialize_(lsz, &gc, q, w);
 
-  // node
-  //  CM.Comm_S_node(q, gc, req);
-  //  CM.Comm_S_wait_node(q, gc, req);
+  // q, wを集約して1メッセージで通信
+  CommFieldList fl;
+  fl.add(q);
+  fl.add(w);
 
-    CM.Comm_S_cell(q, gc, req);
-    CM.Comm_S_wait_cell(q, gc, req);
-
-  // node
-  //  CM.Comm_S_node(w, gc, req);
-  //  CM.Comm_S_wait_node(w, gc, req);
-  
-    CM.Comm_S_cell(w, gc, req);
-    CM.Comm_S_wait_cell(w, gc, req);
+  CM.Comm_fields(&fl, gc, req);
+  CM.Comm_fields_wait(&fl, gc, req);
 
   REAL_TYPE time = 0.0;
   REAL_TYPE res;
@@ -361,17 +390,21 @@ int main(int argc, char * argv[])
     // boundary condition
     bc_(lsz, &gc, q, &P_phys.dh, P_phys.org, nID);
 
-    // node
-    //  CM.Comm_S_node(q, gc, req);
-    //  CM.Comm_S_wait_node(q, gc, req);
+    // 通信中に内部領域を計算し、袖が揃った境界領域から順に計算
+    if ( !CM.Comm_overlap(&ov, q, gc) ) MPI_Abort(MPI_COMM_WORLD, -1);
 
-      CM.Comm_S_cell(q, gc, req);
-      CM.Comm_S_wait_cell(q, gc, req);
+    // time marching
+    res = euler_box(lsz, gc, ov.ist, ov.ied, q, w, &P_phys);
 
+    int face;
+    while ( true )
+    {
+      if ( !CM.Comm_overlap_next(&ov, q, &face) ) MPI_Abort(MPI_COMM_WORLD, -1);
+      if ( face < 0 ) break;
+      res += euler_box(lsz, gc, ov.b_st[face], ov.b_ed[face], q, w, &P_phys);
+    }
 
-    // time marching
-    res = 0.0;
-    euler_explicit_(lsz, &gc, q, w, &P_phys.dh, &P_phys.dt, &P_phys.alpha, &res);
+    update_q_(lsz, &gc, q, w);
 
     REAL_TYPE tmp=res;
 
@@ -20,9 +20,13 @@
 #include <mpi.h>
 
 #include <string>
+#include <complex>
 #include <stdlib.h>
 #include "CB_Define.h"
 #include "CB_Pack.h"
+#include "CB_CommPlan.h"
+
+class CommProgressThread;
 
 
 class BrickComm {
@@ -30,13 +34,57 @@ class BrickComm {
 private:
   int size[3];          ///< 各サブドメインの要素数 (Local, Non-dimensional
   int comm_tbl[NOFACE]; ///< 隣接ブロックのランク番号
+  unsigned dir_self;    ///< 隣接ランクが自ランクの方向のビット（周期境界で分割数1の軸）
 
   MPI_Comm mpi_comm;    ///< MPI コミュニケーター
   int halo_width;       ///< ガイドセル幅
   int buf_flag;         ///< バッファを確保済みのときに1
+  int buf_compo;        ///< バッファを確保した成分数
+  int buf_sweep;        ///< 面のバッファをCOMM_SWEEPの大きさ（先の軸の袖を含む）で確保するとき1
+  unsigned buf_opt;     ///< バッファの確保方法 (BUFoption)
+  char* f_raw;          ///< 全方向のバッファを切り出す領域（確保したまま）
   std::string grid_type;///< "cell" or "node"
+  int comm_mode;        ///< 袖通信の方式 (COMMmode)
+  int vec_layout;       ///< ベクトル配列の成分の並び (VECLayout)
+  int comm_tag;         ///< 袖通信の識別番号（タグは comm_tag*NOFACE + 送信側の方向）
+
+  CommDtype dt_cache[CB_DTYPE_CACHE]; ///< 派生データ型のキャッシュ
+  int dt_next;          ///< 次に置き換えるキャッシュ
+
+  MPI_Comm nbr_comm;    ///< 近傍集団通信のトポロジーコミュニケータ
+  int nbr_num;          ///< 近傍集団通信の隣接数
+  int nbr_sdir[NOFACE]; ///< 近傍集団通信の送信先の方向（方向の順）
+  int nbr_rdir[NOFACE]; ///< 近傍集団通信の受信元の方向（送信側の方向の順）
+
+  MPI_Win rma_win;      ///< RMAの受信ウィンドウ
+  MPI_Group rma_grp;    ///< RMAで同期する隣接ランクのグループ
+  char* rma_buf;        ///< 受信ウィンドウの領域
+  MPI_Aint rma_ofs[NOFACE];  ///< 受信ウィンドウ内の受信方向ごとの位置（バイト、RMA・共有メモリ共通）
+  MPI_Aint rma_disp[NOFACE]; ///< 送信先の受信ウィンドウ内の位置（バイト、RMA・共有メモリ共通）
+
+  MPI_Comm shm_comm;    ///< 同じノードのランクのコミュニケータ
+  MPI_Win shm_win;      ///< 共有メモリの受信ウィンドウ
+  char* shm_buf;        ///< 自ランクの受信ウィンドウの領域
+  char* shm_ptr[NOFACE];///< 同じノードの送信先の受信領域（他ノードはNULL）
+
+  char* zip_buf;        ///< 圧縮通信の送受信領域
+  size_t zip_ofs[NOFACE];   ///< 圧縮通信の方向ごとの位置（送信、受信の順）
+  size_t zip_cap[NOFACE];   ///< 圧縮通信の方向ごとの送信、受信それぞれの大きさ
+  size_t zip_threshold; ///< 圧縮するメッセージの最小のバイト数
+  double zip_ratio;     ///< 圧縮後/圧縮前がこれ以下のときに圧縮したメッセージを送る
+  int zip_skip[NOFACE]; ///< 圧縮を見送る残りの通信回数
+  int zip_recv[NOFACE]; ///< 圧縮通信の方向ごとの受信バイト数（-1-未完了）
+  size_t zip_raw;       ///< 圧縮前の送信バイト数の合計
+  size_t zip_sent;      ///< 実際に送信したバイト数の合計
+
+  CommProgressThread* pg_thread; ///< 通信を進めるスレッド（未使用はNULL）
+
+  unsigned dir_arrived;  ///< Comm_S_*, Comm_V_*で受信を完了した方向のビット
+  unsigned dir_unpacked; ///< Comm_S_*, Comm_V_*でunpack済みの方向のビット
+  int comm_active;       ///< 共有のバッファ・状態を使う袖通信が進行中のとき1（同時に1つ）
+  int kf_posted;         ///< Comm_kface()でK面の送信を開始済みのとき1
 
-  // バッファは8バイトで確保(double, long long)
+  // バッファは8バイトで確保(double, long long)、f_rawからCB_BUF_ALIGN境界で切り出す
   double* f_ims;  // I- direction send
   double* f_imr;  // I- direction recv
   double* f_ips;  // I+ direction send
@@ -64,8 +112,39 @@ public:
   BrickComm() {
     halo_width = 0;
     buf_flag = 0;
+    buf_compo = 0;
+    buf_sweep = 0;
+    buf_opt = BUF_DEFAULT;
+    f_raw = NULL;
+    comm_mode = COMM_PACK;
+    vec_layout = LAYOUT_SOA;
+    comm_tag = 0;
+    mpi_comm = MPI_COMM_NULL;
+    nbr_comm = MPI_COMM_NULL;
+    nbr_num = 0;
+    rma_win = MPI_WIN_NULL;
+    rma_grp = MPI_GROUP_NULL;
+    rma_buf = NULL;
+    shm_comm = MPI_COMM_NULL;
+    shm_win = MPI_WIN_NULL;
+    shm_buf = NULL;
+    zip_buf = NULL;
+    zip_threshold = 65536;
+    zip_ratio = 0.9;
+    zip_raw = 0;
+    zip_sent = 0;
+    for (int i=0; i<NOFACE; i++) zip_skip[i] = 0;
+    for (int i=0; i<NOFACE; i++) zip_recv[i] = -1;
+    pg_thread = NULL;
+    for (int i=0; i<NOFACE; i++) shm_ptr[i] = NULL;
+    dt_next = 0;
+    dir_arrived = 0;
+    dir_unpacked = 0;
+    comm_active = 0;
+    kf_posted = 0;
 
     for (int i=0; i<NOFACE; i++) comm_tbl[i] = -1;
+    dir_self = 0;
 
     for (int i=0; i<3; i++) size[i] = 0;
 
@@ -90,27 +169,21 @@ public:
   }
   
   // デストラクタ
+  // 集団操作は行わない。近傍集団通信のトポロジー、RMA・共有メモリの受信ウィンドウは
+  // 事前にfreeCommResources()で解放する（解放されていなければ警告し、MPIに残す）
   ~BrickComm() {
-    if ( buf_flag == 1 ) {
-      delete [] f_ims;
-      delete [] f_imr;
-      delete [] f_ips;
-      delete [] f_ipr;
-      delete [] f_jms;
-      delete [] f_jmr;
-      delete [] f_jps;
-      delete [] f_jpr;
-      delete [] f_kms;
-      delete [] f_kmr;
-      delete [] f_kps;
-      delete [] f_kpr;
-#ifdef _DIAGONAL_COMM
-      delete [] f_es;
-      delete [] f_er;
-      delete [] f_cs;
-      delete [] f_cr;
-#endif
+    stopProgressThread();
+
+    for (int i=0; i<CB_DTYPE_CACHE; i++) dt_cache[i].clear();
+
+    // MPI_Finalize()後はMPIが解放済み
+    int flag = 0;
+    MPI_Finalized(&flag);
+    if ( !flag && hasCommResources() ) {
+      printf("Warning : freeCommResources() was not called, MPI communicator/windows are leaked\n");
     }
+
+    freeBuffer();
   }
 
 
@@ -123,6 +196,9 @@ public:
    * @param [in] m_comm コミュニケータ
    * @param [in] m_tbl  隣接IDテーブル
    * @param [in] m_type "node" or "cell"
+   * @note 集団操作は行わない。近傍集団通信のトポロジー、RMA・共有メモリの
+   *       受信ウィンドウを作成済みのときは、先にfreeCommResources()を全ランクで呼ぶ
+   *       （呼ばずに設定し直すとエラー）
    */
   bool setBrickComm(const int m_sz[],
                     const int m_halo,
@@ -130,6 +206,16 @@ public:
                     const int m_tbl[],
                     std::string m_type)
   {
+    // 受信ウィンドウなどは大きさ、隣接ランクによるので、解放してから設定する
+    if ( hasCommResources() ) {
+      printf("Error : call freeCommResources() on all ranks before setBrickComm()\n");
+      return false;
+    }
+
+    // 大きさが変わる場合は、次のinit()で確保し直す
+    if ( m_sz[0] != size[0] || m_sz[1] != size[1] || m_sz[2] != size[2] ||
+         m_halo != halo_width ) freeBuffer();
+    
     this->size[0] = m_sz[0];
     this->size[1] = m_sz[1];
     this->size[2] = m_sz[2];
@@ -140,6 +226,14 @@ public:
     for (int i=0; i<NOFACE; i++)
       this->comm_tbl[i] = m_tbl[i];
     
+    // 自ランクとの通信は、MPIを介さずに配列内でコピーする
+    int rank = -1;
+    if ( m_comm != MPI_COMM_NULL ) MPI_Comm_rank(m_comm, &rank);
+    dir_self = 0;
+    for (int i=0; i<NOFACE; i++) {
+      if ( m_tbl[i] >= 0 && m_tbl[i] == rank ) dir_self |= (1u << i);
+    }
+    
     if (m_type == "node" || m_type == "cell") {
       // ok
     }
@@ -157,6 +251,10 @@ public:
   /* #########################################################
    * @brief 通信バッファの確保
    * @param [in] gnum_compo バッファで利用する最大の層数（1-scalar, 3-vector, ?-others）
+   * @note Comm_fields()で集約通信する場合は、登録する配列の成分数の合計とする
+   *       確保済みの成分数より大きい場合は確保し直し、小さい場合はそのまま使う
+   *       受信ウィンドウの大きさは成分数によるので、RMA・共有メモリの受信ウィンドウの
+   *       作成後に確保し直す場合は、先にfreeCommResources()を全ランクで呼ぶ
    */
   bool init(const int num_compo)
   {
@@ -166,52 +264,161 @@ public:
       return false;
     }
     
-    // バッファ領域としては、最大値で確保しておく
-    int f_sz[3];
-    f_sz[0] = size[1] * size[2] * gc * num_compo;
-    f_sz[1] = size[0] * size[2] * gc * num_compo;
-    f_sz[2] = size[0] * size[1] * gc * num_compo;
-    
-    if ( !(f_ims = new double [f_sz[0]]) ) return false;
-    if ( !(f_imr = new double [f_sz[0]]) ) return false;
-    if ( !(f_ips = new double [f_sz[0]]) ) return false;
-    if ( !(f_ipr = new double [f_sz[0]]) ) return false;
+    if ( buf_flag == 1 ) {
+      if ( num_compo <= buf_compo ) return true;
+      
+      // 受信ウィンドウの大きさはbuf_compoによる
+      if ( rma_win != MPI_WIN_NULL || shm_win != MPI_WIN_NULL ) {
+        printf("Error : call freeCommResources() on all ranks before init() with more components\n");
+        return false;
+      }
+      freeBuffer();
+    }
     
-    if ( !(f_jms = new double [f_sz[1]]) ) return false;
-    if ( !(f_jmr = new double [f_sz[1]]) ) return false;
-    if ( !(f_jps = new double [f_sz[1]]) ) return false;
-    if ( !(f_jpr = new double [f_sz[1]]) ) return false;
+    if ( !allocBuffer(num_compo) ) return false;
     
-    if ( !(f_kms = new double [f_sz[2]]) ) return false;
-    if ( !(f_kmr = new double [f_sz[2]]) ) return false;
-    if ( !(f_kps = new double [f_sz[2]]) ) return false;
-    if ( !(f_kpr = new double [f_sz[2]]) ) return false;
+    // packを並列に処理する大きさ（最初のみ）
+    calibrateThreshold();
     
-#ifdef _DIAGONAL_COMM
-    // edge
-    size_t lx = size[0] * gc * gc * num_compo;
-    size_t ly = size[1] * gc * gc * num_compo;
-    size_t lz = size[2] * gc * gc * num_compo;
-    size_t le = lx*4 + ly*4 + lz*4;
-    if ( !(f_es = new double [le]) ) return false;
-    if ( !(f_er = new double [le]) ) return false;
+    buf_flag = 1; // バッファ確保ずみ
+    buf_compo = num_compo;
     
-    // corner
-    size_t lc = gc * gc * gc * num_compo * 8;
-    if ( !(f_cs = new double [lc]) ) return false;
-    if ( !(f_cr = new double [lc]) ) return false;
-#endif
+    return true;
+  }
+
+
+  /* #########################################################
+   * @brief 近傍集団通信のトポロジー、RMA・共有メモリの受信ウィンドウの解放
+   * @retval true-success, false-fail
+   * @note mpi_commの集団操作。COMM_NEIGHBOR, COMM_RMA, COMM_SHMで通信した場合は、
+   *       デストラクタ、setBrickComm()の設定し直しの前に全ランクで呼ぶ
+   *       作成していなければ何もしない。次の通信で作り直す
+   */
+  bool freeCommResources()
+  {
+    if ( comm_active ) {
+      printf("Error : freeCommResources() called during a halo exchange (call the wait first)\n");
+      return false;
+    }
+
+    if ( nbr_comm != MPI_COMM_NULL ) MPI_Comm_free(&nbr_comm);
+    freeRMAWindow();
+    freeShmWindow();
+
+    return true;
+  }
+  
+  
+  /* #########################################################
+   * @brief 袖通信の方式を設定
+   * @param [in] m_mode COMM_PACK-バッファへpack/unpack, COMM_DTYPE-派生データ型,
+   *                    COMM_KFACE-K面の平面を直接送受信,
+   *                    COMM_SWEEP-X, Y, Zの順の面の通信で辺・点も埋める,
+   *                    COMM_NEIGHBOR-近傍集団通信, COMM_RMA-片側通信,
+   *                    COMM_SHM-同じノードは共有メモリ, COMM_ZIP-可逆圧縮
+   * @note Comm_S_*, Comm_V_*, setCommPlan()に適用される
+   *       COMM_SWEEPはcellのComm_S_*, Comm_V_*, Comm_N_*のみ、nodeとプランはエラーとする
+   *       COMM_SWEEPを選んだときに、面のバッファを先の軸の袖を含む大きさに確保し直す
+   *       COMM_NEIGHBOR, COMM_RMA, COMM_SHM, COMM_ZIPはComm_S_*, Comm_V_*のみ、プランはCOMM_PACKとして扱う
+   */
+  bool setCommMode(const int m_mode)
+  {
+    if ( m_mode != COMM_PACK && m_mode != COMM_DTYPE && m_mode != COMM_KFACE &&
+         m_mode != COMM_SWEEP && m_mode != COMM_NEIGHBOR && m_mode != COMM_RMA &&
+         m_mode != COMM_SHM && m_mode != COMM_ZIP ) {
+      printf("Error : Invalid comm mode [%d]\n", m_mode);
+      return false;
+    }
+    if ( m_mode == COMM_SWEEP && !allocSweepBuffer() ) return false;
+    comm_mode = m_mode;
+    return true;
+  }
+  
+  
+  /* #########################################################
+   * @brief 袖通信の方式を返す
+   */
+  int getCommMode() const
+  {
+    return comm_mode;
+  }
+  
+  
+  /* #########################################################
+   * @brief ベクトル配列の成分の並びを設定
+   * @param [in] m_layout LAYOUT_SOA-v(i,j,k,l), LAYOUT_AOS-v(l,i,j,k)
+   * @note 成分数2以上のComm_V_*, Comm_N_*, setCommPlan(), Comm_fields()などに適用される
+   *       LAYOUT_AOSでは、バッファも成分を最内とし、セルごとに連続な成分をまとめてコピーする
+   *       全ランクで同じ並びを設定すること
+   */
+  bool setVecLayout(const int m_layout)
+  {
+    if ( m_layout != LAYOUT_SOA && m_layout != LAYOUT_AOS ) {
+      printf("Error : Invalid vector layout [%d]\n", m_layout);
+      return false;
+    }
+    vec_layout = m_layout;
+    return true;
+  }
+
+
+  /* #########################################################
+   * @brief ベクトル配列の成分の並びを返す
+   */
+  int getVecLayout() const
+  {
+    return vec_layout;
+  }
+  
+  
+  /* #########################################################
+   * @brief 袖通信の識別番号を設定
+   * @param [in] m_tag 識別番号 (0以上)
+   * @note 以降に開始する通信、作成するプランのタグを comm_tag*NOFACE + 送信側の方向とする
+   *       異なる識別番号の通信は、同時に通信中でもメッセージが混ざらない
+   *       同じインスタンスのComm_S_*, Comm_V_*, Comm_N_*などはバッファを共有するので、
+   *       識別番号によらず同時に1つとする。同時に通信する配列は通信プランとする
+   *       全ランクで同じ番号を設定すること
+   */
+  bool setCommTag(const int m_tag)
+  {
+    int* ub = NULL;
+    int flag = 0;
+    if ( mpi_comm != MPI_COMM_NULL ) MPI_Comm_get_attr(mpi_comm, MPI_TAG_UB, &ub, &flag);
     
-    buf_flag = 1; // バッファ確保ずみ
+    int tag_ub = ( flag && ub ) ? *ub : 32767; // MPIの保証する最小値
     
+    if ( m_tag < 0 || m_tag > (tag_ub - NOFACE + 1) / NOFACE ) {
+      printf("Error : Invalid comm tag [%d]\n", m_tag);
+      return false;
+    }
+    comm_tag = m_tag;
     return true;
   }
   
   
+  /* #########################################################
+   * @brief 袖通信の識別番号を返す
+   */
+  int getCommTag() const
+  {
+    return comm_tag;
+  }
+  
+  
   
 // CB_Comm_inline.h
 public:
   
+  /** 利用者の型に派生データ型を登録
+   *  @param[in] dtype コミット済みの派生データ型（大きさ、範囲はsizeof(T)）
+   *  @retval true-success, false-fail
+   *  @note GetMPI_Datatype(), IsendIrecv(), IrecvData(), IsendData(),
+   *        CommFieldList::add()で、Tの配列を扱えるようになる
+   */
+  template<class T>
+  static bool registerType(MPI_Datatype dtype);
+  
   /** MPI_Datatypeを取得
    *  @param[in] ptr 取得したいデータのポインタ
    *  @return MPI_Datatype
@@ -229,6 +436,7 @@ public:
    * @param [in]  msz  send/recieve size
    * @param [in]  nIDm Neighbor ID for Minus direction
    * @param [in]  nIDp Neighbor ID for Plus direction
+   * @param [in]  dir_m Minus direction (I_minus, J_minus, K_minus)
    * @param [out] req  Array of MPI request
    * @retval true-success, false-fail
    */
@@ -240,6 +448,7 @@ public:
                   int msz,
                   int nIDm,
                   int nIDp,
+                  int dir_m,
                   MPI_Request *req);
   
   
@@ -248,185 +457,1366 @@ public:
    * @param [out]    ptr  Recieve pointer
    * @param [in]     sz   Recieve data size
    * @param [in]     nID  Neighbor ID
+   * @param [in]     tag  Tag (送信側の方向のgetTag())
    * @param [in,out] req  Array of MPI request
    */
   template <class T> inline
   bool IrecvData(T* ptr,
                  int sz,
                  int nID,
+                 int tag,
+                 MPI_Request *req);
+  
+  
+  /*
+   * @brief Isend
+   * @param [in]     ptr  Send pointer
+   * @param [in]     sz   Send data size
+   * @param [in]     nID  Neighbor ID
+   * @param [in]     tag  Tag (送信方向のgetTag())
+   * @param [in,out] req  Array of MPI request
+   */
+  template <class T> inline
+  bool IsendData(T* ptr,
+                 int sz,
+                 int nID,
+                 int tag,
                  MPI_Request *req);
+
+  
+  
+  
+// CB_Comm.cpp
+public:
+  
+  /*
+   * @brief 隣接間通信 IsendIrecv Interface 2
+   * @param [in]  dtype  送受信データの型
+   * @param [in]  ms     Send buffer to Minus direction
+   * @param [out] mr     Recieve buffer from Mminus direction
+   * @param [in]  ps     Send buffer to Plus direction
+   * @param [out] pr     Recieve buffer from Plus direction
+   * @param [in]  msz    send/recieve size
+   * @param [in]  nIDm   Neighbor ID for Minus direction
+   * @param [in]  nIDp   Neighbor ID for Plus direction
+   * @param [in]  dir_m  Minus direction (I_minus, J_minus, K_minus)
+   * @param [out] req    Array of MPI request
+   * @retval true-success, false-fail
+   * @note mpi_commで送受信し、タグは送信側の方向のgetTag()とする
+   */
+  bool IsendIrecv(MPI_Datatype dtype,
+                  void* ms,
+                  void* mr,
+                  void* ps,
+                  void* pr,
+                  int msz,
+                  int nIDm,
+                  int nIDp,
+                  int dir_m,
+                  MPI_Request* req);
+
+  
+  /*
+   * @brief Irecv
+   * @param [in]     dtype 受信データの型
+   * @param [out]    ptr   Recieve pointer
+   * @param [in]     sz    Recieve data size
+   * @param [in]     nID   Neighbor ID
+   * @param [in]     tag   Tag (送信側の方向のgetTag())
+   * @param [in,out] req   Array of MPI request
+   */
+  bool IrecvData(MPI_Datatype dtype,
+                 void* ptr,
+                 int sz,
+                 int nID,
+                 int tag,
+                 MPI_Request* req);
+  
+
+  /*
+   * @brief Isend
+   * @param [in]     dtype 送信データの型
+   * @param [in]     ptr   Send pointer
+   * @param [in]     sz    Send data size
+   * @param [in]     nID   Neighbor ID
+   * @param [in]     tag   Tag (送信方向のgetTag())
+   * @param [in,out] req   Array of MPI request
+   */
+  bool IsendData(MPI_Datatype dtype,
+                 void* ptr,
+                 int sz,
+                 int nID,
+                 int tag,
+                 MPI_Request* req);
+  
+  
+  
+  
+public:
+  
+  /* #########################################################
+   * @brief スカラー変数 node
+   * @param [in,out]  src     スカラー変数
+   * @param [in]      gc_comm 実際に通信する通信面数
+   * @param [in,out]  req     MPI_Request
+   * @param [in]      prec    転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask    袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_S_node(T* src, const int gc_comm, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+
+
+  /* #########################################################
+   * @brief スカラー変数 cell
+   * @param [in,out]  src     スカラー変数
+   * @param [in]      gc_comm 実際に通信する通信面数
+   * @param [in,out]  req     MPI_Request
+   * @param [in]      prec    転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask    袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_S_cell(T* src, const int gc_comm, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+  
+  
+  /* #########################################################
+   * @brief スカラー変数 node
+   * @param [in,out]  dest    スカラー変数
+   * @param [in]      gc_comm 実際に通信する通信面数
+   * @param [out]     req     Array of MPI request
+   * @param [in]      prec    転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask    袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_S_wait_node(T* dest, const int gc_comm, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+  
+  
+  /* #########################################################
+   * @brief スカラー変数 cell
+   * @param [in,out]  dest    スカラー変数
+   * @param [in]      gc_comm 実際に通信する通信面数
+   * @param [out]     req     Array of MPI request
+   * @param [in]      prec    転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask    袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_S_wait_cell(T* dest, const int gc_comm, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+
+  
+  
+  
+// CB_CommV.cpp
+public:
+  
+  /* #########################################################
+   * @brief ベクトル変数 node
+   * @param [in,out]  src     ベクトル変数
+   * @param [in]      gc_comm 実際に通信する通信面数
+   * @param [in,out]  req     MPI_Request
+   * @param [in]      prec    転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask    袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_V_node(T* src, const int gc_comm, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+
+  
+  /* #########################################################
+   * @brief ベクトル変数 cell
+   * @param [in,out]  src     ベクトル変数
+   * @param [in]      gc_comm 実際に通信する通信面数
+   * @param [in,out]  req     MPI_Request
+   * @param [in]      prec    転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask    袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_V_cell(T* src, const int gc_comm, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+  
+  
+  /* #########################################################
+   * @brief ベクトル変数 node
+   * @param [in,out]  dest    ベクトル変数
+   * @param [in]      gc_comm 実際に通信する通信面数
+   * @param [out]     req     Array of MPI request
+   * @param [in]      prec    転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask    袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_V_wait_node(T* dest, const int gc_comm, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+
+  
+  /* #########################################################
+   * @brief ベクトル変数 cell
+   * @param [in,out]  dest    ベクトル変数
+   * @param [in]      gc_comm 実際に通信する通信面数
+   * @param [out]     req     Array of MPI request
+   * @param [in]      prec    転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask    袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_V_wait_cell(T* dest, const int gc_comm, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+  
+
+  
+  
+// CB_CommN.cpp
+public:
+  
+  /* #########################################################
+   * @brief N成分の変数 node
+   * @param [in,out]  src       N成分の変数
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (init()で与えた成分数以下)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @param [in]      prec      転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask      袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_N_node(T* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+
+
+  /* #########################################################
+   * @brief N成分の変数 cell
+   * @param [in,out]  src       N成分の変数
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (init()で与えた成分数以下)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @param [in]      prec      転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask      袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_N_cell(T* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+
+
+  /* #########################################################
+   * @brief N成分の変数の完了待ち node
+   * @param [in,out]  dest      N成分の変数
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (init()で与えた成分数以下)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @param [in]      prec      転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask      袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_N_wait_node(T* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+
+
+  /* #########################################################
+   * @brief N成分の変数の完了待ち cell
+   * @param [in,out]  dest      N成分の変数
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (init()で与えた成分数以下)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @param [in]      prec      転送精度 (PRECmode)、waitには開始と同じ値
+   * @param [in]      mask      袖を受信する方向 (DIRmask)、waitには開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_N_wait_cell(T* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+
+
+private:
+
+  /*
+   * @brief comm_modeに応じた袖通信の開始
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @param [in]      prec      転送精度 (PRECmode)
+   * @param [in]      mask      袖を受信する方向 (DIRmask)
+   * @retval true-success, false-fail
+   * @note Comm_S_*, Comm_V_*, Comm_N_*はすべてここで振り分ける
+   */
+  template <class T>
+  bool comm_Start(T* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+
+  /*
+   * @brief comm_modeに応じた袖通信の完了待ち
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @param [in]      prec      転送精度 (PRECmode)、開始と同じ値
+   * @param [in]      mask      袖を受信する方向 (DIRmask)、開始と同じ値
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool comm_Finish(T* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+
+  /*
+   * @brief 方向ごとにpackし、送受信を開始 (COMM_PACK)
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @param [in]      mask      袖を受信する方向 (DIRmask)
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool box_Start(T* src, const int gc_comm, const int num_compo, MPI_Request *req, const unsigned mask);
+
+
+  /*
+   * @brief 面ごとにpack_S*, pack_V*でpackし、送受信を開始 (COMM_PACK, 1スレッド)
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1 or 3)
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool legacy_Start(T* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+  
+  
+// CB_CommPlan.cpp
+public:
+  
+  /* #########################################################
+   * @brief 袖通信プランの作成（永続通信）
+   * @param [out]     pl        通信プラン
+   * @param [in]      src       通信する配列（型と形状の確認に利用）
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @retval true-success, false-fail
+   * @note 同一の型・形状の配列であれば、複数の配列で使い回せる
+   *       COMM_DTYPEの場合は作成時のsrcに束縛される
+   */
+  template <class T>
+  bool setCommPlan(CommPlan* pl, T* src, const int gc_comm, const int num_compo=1);
+  
+  
+  /* #########################################################
+   * @brief 通信プランによる袖通信の開始
+   * @param [in,out]  pl   通信プラン
+   * @param [in]      src  送信する配列
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_plan(CommPlan* pl, T* src);
+  
+  
+  /* #########################################################
+   * @brief 通信プランによる袖通信の完了待ち
+   * @param [in,out]  pl    通信プラン
+   * @param [in,out]  dest  受信する配列
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_plan_wait(CommPlan* pl, T* dest);
+  
+  
+  /*
+   * @brief 隣接方向のオフセットを返す
+   * @param [in]  dir 方向 (DIRection)
+   * @param [out] o   各軸のオフセット {-1, 0, 1}
+   */
+  static void getDirOffset(const int dir, int* o);
+  
+  
+  /*
+   * @brief 反対方向を返す
+   * @param [in]  dir 方向 (DIRection)
+   */
+  static int getOppositeDir(const int dir);
+  
+  
+  /*
+   * @brief 方向dirへの送信のタグを返す
+   * @param [in]  dir 送信側の方向 (DIRection)
+   * @note 受信は getTag(getOppositeDir(dir)) とする
+   */
+  int getTag(const int dir) const;
+  
+  
+  /*
+   * @brief 方向dirの送受信領域を作成
+   * @param [in]  dir 方向 (DIRection)
+   * @param [in]  gc  通信する袖の層数
+   * @param [out] b   送受信領域
+   */
+  void setCommBox(const int dir, const int gc, CommBox* b);
+  
+  
+  /*
+   * @brief K面の送受信領域を袖を含む平面で作成
+   * @param [in]  dir 方向 (K_minus, K_plus)
+   * @param [in]  gc  通信する袖の層数
+   * @param [out] b   送受信領域
+   */
+  void setCommBox_K(const int dir, const int gc, CommBox* b);
+  
+  
+private:
+  
+  /*
+   * @brief 派生データ型による永続リクエストの作成
+   * @param [in,out]  pl   通信プラン
+   * @param [in]      src  通信する配列
+   */
+  template <class T>
+  bool setCommPlan_dtype(CommPlan* pl, T* src);
+  
+  
+  /*
+   * @brief K面の平面による永続リクエストの作成
+   * @param [in,out]  pl   通信プラン
+   * @param [in]      src  通信する配列
+   */
+  template <class T>
+  bool setCommPlan_kface(CommPlan* pl, T* src);
+  
+  
+  
+// CB_CommDtype.cpp
+public:
+  
+  /* #########################################################
+   * @brief 派生データ型による袖通信の開始
+   * @param [in,out]  src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   * @note pack/unpackを行わず、配列から直接送受信する
+   */
+  template <class T>
+  bool Comm_dtype(T* src, const int gc_comm, const int num_compo, MPI_Request *req);
+  
+  
+  /* #########################################################
+   * @brief 派生データ型による袖通信の完了待ち
+   * @param [in,out]  req  Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   */
+  bool Comm_dtype_wait(MPI_Request *req);
+  
+  
+private:
+  
+  /*
+   * @brief 派生データ型をキャッシュから取得、なければ作成
+   * @param [in] base 要素の型
+   * @param [in] gc   通信する袖の層数
+   * @param [in] nc   成分数
+   * @return 派生データ型, 失敗時はNULL
+   */
+  CommDtype* getCommType(MPI_Datatype base, const int gc, const int nc);
+  
+  
+  /*
+   * @brief 派生データ型の送受信領域
+   * @param [in]  dir 方向 (DIRection)
+   * @param [in]  gc  通信する袖の層数
+   * @param [out] b   送受信領域
+   */
+  void setCommBox_Dtype(const int dir, const int gc, CommBox* b);
+  
+  
+  /*
+   * @brief 配列上の(i,j,k)の先頭の成分の位置
+   * @param [in] i, j, k 位置
+   * @param [in] nc      成分数
+   * @note 成分の並びはvec_layoutによる
+   */
+  size_t getVecOffset(const int i, const int j, const int k, const int nc) const
+  {
+    const CB_Index A(size[0], size[1], size[2], halo_width);
+    return ( vec_layout == LAYOUT_AOS && nc > 1 ) ? A(i,j,k) * nc : A(i,j,k);
+  }
+  
+  
+  
+// CB_CommKface.cpp
+public:
+  
+  /* #########################################################
+   * @brief K面の平面を直接送受信する袖通信の開始
+   * @param [in,out]  src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   * @note X, Y方向の面（斜め通信ではXY辺も）をpackして送受信を開始する
+   *       cellではK面の受信も開始する（nodeはX, Y方向のunpack後）
+   */
+  template <class T>
+  bool Comm_kface(T* src, const int gc_comm, const int num_compo, MPI_Request *req);
+  
+  
+  /* #########################################################
+   * @brief K面の平面を直接送受信する袖通信の完了待ち
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   * @note K面の送信が未開始であれば kface_Post() で開始し、全ての完了を待つ
+   */
+  template <class T>
+  bool Comm_kface_wait(T* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+  
+  
+private:
+  
+  /*
+   * @brief X, Y方向の受信を待ってunpackし、K面の送信を開始
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @note K面の平面はX, Y方向の袖を含むので、送信はunpackの後とする
+   *       Comm_kface_wait()、progress()から呼ぶ。開始済みなら何もしない
+   */
+  template <class T>
+  bool kface_Post(T* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+  
+  /*
+   * @brief 方向ごとの送受信バッファ
+   * @param [in]  dir 方向
+   * @param [out] sb  送信バッファ
+   * @param [out] rb  受信バッファ
+   * @note init()で確保したバッファ内の方向ごとの固定位置を返す
+   */
+  bool getDirBuf(const int dir, char** sb, char** rb);
+
+  
+  /*
+   * @brief 要素の型T、成分数num_compoの袖がバッファに収まるか
+   * @param [in] p         配列（型の指定のみ）
+   * @param [in] num_compo 成分数
+   * @note バッファはinit()の成分数 x 8バイトで確保されている
+   *       8バイトを超える型（std::complex<double>など）は、その分の成分数が要る
+   */
+  template <class T>
+  bool isBufCompo(const T* /* p */, const int num_compo) const
+  {
+    return ( num_compo >= 1 && sizeof(T) * num_compo <= sizeof(double) * buf_compo );
+  }
+
+
+  /*
+   * @brief 全方向を通信するマスクか
+   * @param [in] mask 袖を受信する方向 (DIRmask)
+   * @note 一部の方向のみの通信は、comm_modeによらず方向ごとのbox (COMM_PACK) で行う
+   */
+  bool isAllDir(const unsigned mask) const
+  {
+    const unsigned all = (1u << NOFACE) - 1;
+    return ( (mask & all) == all );
+  }
+
+
+  /*
+   * @brief freeCommResources()で解放する資源が残っているか
+   */
+  bool hasCommResources() const
+  {
+    return ( nbr_comm != MPI_COMM_NULL || rma_win != MPI_WIN_NULL || shm_win != MPI_WIN_NULL );
+  }
+
+
+  /*
+   * @brief 呼び出したエントリの格子の種類がinit()と一致するか
+   * @param [in] grid "cell" or "node"
+   * @note Comm_?_cellをnodeのインスタンスで呼ぶ（またはその逆）とエラー
+   */
+  bool isGridType(const char* grid) const
+  {
+    if ( grid_type == grid ) return true;
+    printf("Error : %s entry called on a %s communicator\n", grid, grid_type.c_str());
+    return false;
+  }
+
+
+  /*
+   * @brief 従来の面ごとのpack_S*, pack_V* (legacy_Start) で通信するか
+   * @param [in] num_compo 成分数
+   * @note 1スレッド、自ランクとの通信なし、スカラーまたはSOAの3成分ベクトル
+   */
+  bool isLegacyPack(const int num_compo) const
+  {
+    if ( dir_self ) return false;
+    if ( num_compo != 1 && !(num_compo == 3 && vec_layout == LAYOUT_SOA) ) return false;
+#ifdef _OPENMP
+    if ( omp_get_max_threads() > 1 ) return false;
+#endif
+    return true;
+  }
+
+  
+  
+// CB_CommSweep.cpp
+public:
+
+  /* #########################################################
+   * @brief X, Y, Zの順の面の通信で辺・点も埋める袖通信の開始
+   * @param [in,out]  src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   * @note X面の送受信を開始する
+   */
+  template <class T>
+  bool Comm_sweep(T* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+  /* #########################################################
+   * @brief X, Y, Zの順の面の通信で辺・点も埋める袖通信の完了待ち
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   * @note X面をunpackした後、Y面、Z面を先の方向の袖を含めて順に送受信する
+   */
+  template <class T>
+  bool Comm_sweep_wait(T* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+private:
+
+  /*
+   * @brief sweepの面の送受信領域
+   * @param [in]  dir 方向 (I_minus - K_plus)
+   * @param [in]  gc  通信する袖の層数
+   * @param [out] b   送受信領域
+   */
+  void setCommBox_Sweep(const int dir, const int gc, CommBox* b);
+
+
+  /*
+   * @brief 1方向の面の送受信を開始
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [in]      axis      軸 (0-X, 1-Y, 2-Z)
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   */
+  template <class T>
+  bool sweep_Start(T* src, const int gc_comm, const int num_compo, const int axis, MPI_Request *req);
+
+
+  /*
+   * @brief 1方向の面の受信を待ち、unpack
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [in]      axis      軸 (0-X, 1-Y, 2-Z)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   */
+  template <class T>
+  bool sweep_Finish(T* dest, const int gc_comm, const int num_compo, const int axis, MPI_Request *req);
+
+
+
+// CB_CommNeighbor.cpp
+public:
+
+  /* #########################################################
+   * @brief 近傍集団通信による袖通信の開始
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [out]     req       Array of MPI request (NOFACE*2)、req[0]のみ使用
+   * @retval true-success, false-fail
+   * @note 全方向をpackし、MPI_Ineighbor_alltoallwの1回で送受信する
+   */
+  template <class T>
+  bool Comm_neighbor(T* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+  /* #########################################################
+   * @brief 近傍集団通信による袖通信の完了待ち
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_neighbor_wait(T* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+private:
+
+  /*
+   * @brief comm_tblから近傍集団通信のトポロジーを作成
+   * @retval true-success, false-fail
+   * @note mpi_commの集団操作、作成済みのときは何もしない
+   */
+  bool setNeighborComm();
+
+
+
+// CB_CommRMA.cpp
+public:
+
+  /* #########################################################
+   * @brief 片側通信による袖通信の開始
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [out]     req       Array of MPI request (NOFACE*2)、使用しない
+   * @retval true-success, false-fail
+   * @note 全方向をpackし、隣接ランクの受信ウィンドウへMPI_Putで書き込む
+   */
+  template <class T>
+  bool Comm_rma(T* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+  /* #########################################################
+   * @brief 片側通信による袖通信の完了待ち
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_rma_wait(T* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+private:
+
+  /*
+   * @brief 受信方向ごとの領域の位置を設定
+   * @retval 全方向の領域のバイト数
+   */
+  MPI_Aint setRecvSlot();
+
+
+  /*
+   * @brief 隣接ランクと受信領域の位置を交換
+   * @retval true-success, false-fail
+   */
+  bool exchangeRecvSlot();
+
+
+  /*
+   * @brief 受信ウィンドウの作成と、隣接ランクとの書き込み位置の交換
+   * @retval true-success, false-fail
+   * @note mpi_commの集団操作、作成済みのときは何もしない
+   */
+  bool setRMAWindow();
+
+
+  /*
+   * @brief 受信ウィンドウの解放
+   * @note mpi_commの集団操作
+   */
+  void freeRMAWindow();
+
+
+
+// CB_CommShm.cpp
+public:
+
+  /* #########################################################
+   * @brief 同じノードの隣接ランクと共有メモリで行う袖通信の開始
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   * @note 同じノードの隣接ランクへは受信領域へ直接pack、他ノードはIsend/Irecv
+   */
+  template <class T>
+  bool Comm_shm(T* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+  /* #########################################################
+   * @brief 同じノードの隣接ランクと共有メモリで行う袖通信の完了待ち
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_shm_wait(T* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+private:
+
+  /*
+   * @brief 共有メモリの受信ウィンドウの作成と、同じノードの隣接ランクの受信領域の取得
+   * @retval true-success, false-fail
+   * @note mpi_commの集団操作、作成済みのときは何もしない
+   */
+  bool setShmWindow();
+
+
+  /*
+   * @brief 共有メモリの受信ウィンドウの解放
+   * @note mpi_commの集団操作
+   */
+  void freeShmWindow();
+
+
+
+// CB_CommReduced.cpp
+private:
+
+  /*
+   * @brief 精度を落とした袖通信の開始
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [in]      prec      転送精度 (PREC_FLOAT, PREC_BF16)
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @param [in]      mask      袖を受信する方向 (DIRmask)
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_reduced(T* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+
+  /*
+   * @brief 精度を落とした袖通信の完了待ち
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [in]      prec      転送精度 (PREC_FLOAT, PREC_BF16)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @param [in]      mask      袖を受信する方向 (DIRmask)
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_reduced_wait(T* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+
+  /*
+   * @brief 転送する型Uに変換してpackし、送受信を開始
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [in]      u         転送する型（型の指定のみ、NULL）
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @param [in]      mask      袖を受信する方向 (DIRmask)
+   */
+  template <class T, class U>
+  bool reduced_Start(T* src, const int gc_comm, const int num_compo, U* u, MPI_Request *req, const unsigned mask);
+
+
+  /*
+   * @brief 受信を待ち、転送する型Uから配列の型に戻してunpack
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [in]      u         転送する型（型の指定のみ、NULL）
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @param [in]      mask      袖を受信する方向 (DIRmask)
+   */
+  template <class T, class U>
+  bool reduced_Finish(T* dest, const int gc_comm, const int num_compo, U* u, MPI_Request *req, const unsigned mask);
+
+
+
+// CB_CommZip.cpp
+public:
+
+  /* #########################################################
+   * @brief 圧縮通信の設定
+   * @param [in] threshold 圧縮するメッセージの最小のバイト数
+   * @param [in] ratio     圧縮後/圧縮前がこれ以下のときに圧縮したメッセージを送る
+   * @retval true-success, false-fail
+   * @note 見合わなかった方向は、CB_ZIP_RETRY回の通信の間は圧縮しない
+   */
+  bool setCompress(const size_t threshold=65536, const double ratio=0.9);
+
+
+  /* #########################################################
+   * @brief 圧縮通信の統計
+   * @param [out] raw  圧縮前の送信バイト数の合計
+   * @param [out] sent 実際に送信したバイト数の合計
+   */
+  void getCompressStat(size_t* raw, size_t* sent);
+
+
+  /* #########################################################
+   * @brief 可逆圧縮した袖通信の開始
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   * @note 4, 8バイトの型のみ
+   */
+  template <class T>
+  bool Comm_zip(T* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+  /* #########################################################
+   * @brief 可逆圧縮した袖通信の完了待ち
+   * @param [in,out]  dest      通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   */
+  template <class T>
+  bool Comm_zip_wait(T* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+private:
+
+  /*
+   * @brief 圧縮通信の送受信領域の確保
+   * @retval true-success, false-fail
+   * @note 確保済みのときは何もしない
+   */
+  bool setZipBuffer();
+
+
+  /*
+   * @brief 圧縮通信の送受信領域の解放
+   */
+  void freeZipBuffer();
+
+
+
+// CB_CommField.cpp
+public:
+  
+  /* #########################################################
+   * @brief 複数の配列の集約袖通信の開始
+   * @param [in,out]  fl        配列のリスト
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [out]     req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   * @note 隣接方向ごとに全配列を1つのバッファにpackし、1メッセージで送受信する
+   *       全配列の成分数の合計は、init()の成分数以下とする
+   */
+  bool Comm_fields(CommFieldList* fl, const int gc_comm, MPI_Request *req);
+  
+  
+  /* #########################################################
+   * @brief 複数の配列の集約袖通信の完了待ち
+   * @param [in,out]  fl        配列のリスト
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @retval true-success, false-fail
+   */
+  bool Comm_fields_wait(CommFieldList* fl, const int gc_comm, MPI_Request *req);
   
   
+private:
+  
   /*
-   * @brief Isend
-   * @param [in]     ptr  Send pointer
-   * @param [in]     sz   Send data size
-   * @param [in]     nID  Neighbor ID
-   * @param [in,out] req  Array of MPI request
+   * @brief 全配列のpack
+   * @param [in]  fl  配列のリスト
+   * @param [in]  b   送受信領域
+   * @param [out] buf 送信バッファ
    */
-  template <class T> inline
-  bool IsendData(T* ptr,
-                 int sz,
-                 int nID,
-                 MPI_Request *req);
-
-  
+  void pack_Fields(const CommFieldList* fl, const CommBox* b, char* buf);
   
   
-// CB_Comm.cpp
-public:
-  
   /*
-   * @brief 隣接間通信 IsendIrecv Interface 2
-   * @param [in]  dtype  送受信データの型
-   * @param [in]  ms     Send buffer to Minus direction
-   * @param [out] mr     Recieve buffer from Mminus direction
-   * @param [in]  ps     Send buffer to Plus direction
-   * @param [out] pr     Recieve buffer from Plus direction
-   * @param [in]  msz    send/recieve size
-   * @param [in]  nIDm   Neighbor ID for Minus direction
-   * @param [in]  nIDp   Neighbor ID for Plus direction
-   * @param [out] req    Array of MPI request
+   * @brief 全配列のunpack
+   * @param [in,out] fl  配列のリスト
+   * @param [in]     b   送受信領域
+   * @param [in]     buf 受信バッファ
+   */
+  void unpack_Fields(CommFieldList* fl, const CommBox* b, const char* buf);
+
+
+
+// CB_CommProgress.cpp
+public:
+
+  /* #########################################################
+   * @brief Comm_S_*, Comm_V_*の通信を進め、受信済みの方向をunpack
+   * @param [in,out]  dest      受信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @param [in]      prec      転送精度 (PRECmode)、開始と同じ値
+   * @param [in]      mask      袖を受信する方向 (DIRmask)、開始と同じ値
    * @retval true-success, false-fail
+   * @note ブロックしない。開始とwaitの間に任意の回数呼べる
    */
-  bool IsendIrecv(MPI_Datatype dtype,
-                  void* ms,
-                  void* mr,
-                  void* ps,
-                  void* pr,
-                  int msz,
-                  int nIDm,
-                  int nIDp,
-                  MPI_Request* req);
+  template <class T>
+  bool progress(T* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec=PREC_FULL, const unsigned mask=DIR_ALL);
+
+
+private:
 
-  
   /*
-   * @brief Irecv
-   * @param [in]     dtype 受信データの型
-   * @param [out]    ptr   Recieve pointer
-   * @param [in]     sz    Recieve data size
-   * @param [in]     nID   Neighbor ID
-   * @param [in,out] req   Array of MPI request
+   * @brief 受信を完了した方向から順にunpack
+   * @param [in,out]  dest      受信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   * @param [in]      block     true-全ての完了まで待つ, false-完了済みのみ
+   * @retval true-success, false-fail
    */
-  bool IrecvData(MPI_Datatype dtype,
-                 void* ptr,
-                 int sz,
-                 int nID,
-                 MPI_Request* req);
-  
+  template <class T>
+  bool unpack_Arrived(T* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+
+
+// CB_CommBuffer.cpp
+public:
+
+  /* #########################################################
+   * @brief 通信バッファの確保方法の設定
+   * @param [in] m_opt BUFoptionの組み合わせ
+   *                   BUF_MPIMEM-MPI_Alloc_memで確保, BUF_HUGEPAGE-huge pageを要求
+   * @retval true-success, false-fail
+   * @note init()の前に指定する。確保し直すときも同じ方法とする
+   */
+  bool setBufOption(const unsigned m_opt);
+
+
+private:
 
   /*
-   * @brief Isend
-   * @param [in]     dtype 送信データの型
-   * @param [in]     ptr   Send pointer
-   * @param [in]     sz    Send data size
-   * @param [in]     nID   Neighbor ID
-   * @param [in,out] req   Array of MPI request
+   * @brief 全方向の通信バッファを1つの領域から切り出して確保
+   * @param [in] num_compo 成分数
+   * @retval true-success, false-fail
    */
-  bool IsendData(MPI_Datatype dtype,
-                 void* ptr,
-                 int sz,
-                 int nID,
-                 MPI_Request* req);
-  
-  
+  bool allocBuffer(const int num_compo);
   
   
+  /*
+   * @brief 面のバッファをCOMM_SWEEPの大きさで確保し直す
+   * @retval true-success, false-fail
+   * @note nodeはエラー。init()前は、init()でCOMM_SWEEPの大きさで確保する
+   */
+  bool allocSweepBuffer();
+
+
+  /*
+   * @brief 通信バッファの解放
+   */
+  void freeBuffer();
+
+
+
+// CB_CommThread.cpp
 public:
-  
+
   /* #########################################################
-   * @brief スカラー変数 node
-   * @param [in,out]  src     スカラー変数
-   * @param [in]      gc_comm 実際に通信する通信面数
-   * @param [in,out]  req     MPI_Request
+   * @brief 通信を進めるスレッドの開始
+   * @param [in] min_us 到着があったときのポーリング間隔 [usec] (0-sched_yield)
+   * @param [in] max_us 到着がないときに倍々に延ばすポーリング間隔の上限 [usec]
+   * @param [in] cpu    スレッドを固定するCPU番号 (-1-固定しない)
+   * @retval true-success, false-fail
+   * @note -D with_Progress=ON でビルドしたときのみ利用できる
+   *       MPI_THREAD_MULTIPLE、またはMPI_THREAD_SERIALIZEDで初期化すること
+   *       SERIALIZEDでは、開始とwaitの間にBrickComm以外のMPIを呼ばない
+   *       COMM_PACKのComm_S_*, Comm_V_*の開始からwaitまでの間、スレッドが
+   *       MPI_Testsomeで通信を進め、到着した方向をunpackする
+   */
+  bool startProgressThread(const int min_us=0, const int max_us=100, const int cpu=-1);
+
+
+  /* #########################################################
+   * @brief 通信を進めるスレッドの終了
+   */
+  void stopProgressThread();
+
+
+private:
+
+  /*
+   * @brief 通信スレッドに開始した通信を渡す
+   * @param [in,out]  dest      受信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数
+   * @param [in]      num_compo 成分数
+   * @param [in,out]  req       Array of MPI request (NOFACE*2)
+   */
+  template <class T>
+  void progress_Post(T* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+  /*
+   * @brief 通信スレッドから通信を取り戻す
+   * @note waitの最初に呼ぶ。スレッドが通信を進めている途中であれば、その終了を待つ
+   */
+  void progress_Cancel();
+
+
+  /*
+   * @brief 通信スレッドが行う1回分の処理
    * @retval true-success, false-fail
    */
   template <class T>
-  bool Comm_S_node(T* src, const int gc_comm, MPI_Request *req);
+  static bool progress_Job(BrickComm* c, void* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+  /*
+   * @brief 通信スレッドの本体
+   */
+  static void* progress_Main(void* arg);
+
 
 
+// CB_CommOverlap.cpp
+public:
+
   /* #########################################################
-   * @brief スカラー変数 cell
-   * @param [in,out]  src     スカラー変数
-   * @param [in]      gc_comm 実際に通信する通信面数
-   * @param [in,out]  req     MPI_Request
+   * @brief 計算とオーバーラップする袖通信の開始
+   * @param [out]     ov        オーバーラップ領域
+   * @param [in]      src       通信する配列
+   * @param [in]      gc_comm   実際に通信する通信面数（ステンシルの幅）
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
    * @retval true-success, false-fail
+   * @note 全方向をpackして送受信を開始し、内部領域と境界領域を設定する
+   *       通信バッファはinit()で確保したものを使う
    */
   template <class T>
-  bool Comm_S_cell(T* src, const int gc_comm, MPI_Request *req);
-  
-  
+  bool Comm_overlap(CommOverlap* ov, T* src, const int gc_comm, const int num_compo=1);
+
+
   /* #########################################################
-   * @brief スカラー変数 node
-   * @param [in,out]  dest    スカラー変数
-   * @param [in]      gc_comm 実際に通信する通信面数
-   * @param [out]     req     Array of MPI request
+   * @brief 計算可能になった境界領域を返す
+   * @param [in,out]  ov    オーバーラップ領域
+   * @param [in,out]  dest  受信する配列
+   * @param [out]     face  境界領域の面番号 (0-5)、全て返した後は-1
    * @retval true-success, false-fail
+   * @note 受信を完了した方向から順にunpackし、依存する方向が揃った境界領域を返す
    */
   template <class T>
-  bool Comm_S_wait_node(T* dest, const int gc_comm, MPI_Request *req);
-  
-  
+  bool Comm_overlap_next(CommOverlap* ov, T* dest, int* face);
+
+
   /* #########################################################
-   * @brief スカラー変数 cell
-   * @param [in,out]  dest    スカラー変数
-   * @param [in]      gc_comm 実際に通信する通信面数
-   * @param [out]     req     Array of MPI request
+   * @brief 計算とオーバーラップする袖通信の完了待ち
+   * @param [in,out]  ov    オーバーラップ領域
+   * @param [in,out]  dest  受信する配列
    * @retval true-success, false-fail
+   * @note 境界領域を個別に計算しない場合に使う
    */
   template <class T>
-  bool Comm_S_wait_cell(T* dest, const int gc_comm, MPI_Request *req);
+  bool Comm_overlap_wait(CommOverlap* ov, T* dest);
 
-  
-  
-  
-// CB_CommV.cpp
+
+private:
+
+  /*
+   * @brief 内部領域と面ごとの境界領域、その依存方向を設定
+   * @param [in,out]  ov   オーバーラップ領域（gc, boxを設定済み）
+   */
+  void setOverlapRegion(CommOverlap* ov);
+
+
+
+// CB_CommDeep.cpp
 public:
-  
+
   /* #########################################################
-   * @brief ベクトル変数 node
-   * @param [in,out]  src     ベクトル変数
-   * @param [in]      gc_comm 実際に通信する通信面数
-   * @param [in,out]  req     MPI_Request
+   * @brief 深い袖による通信回避の設定
+   * @param [out]     dp        通信回避の状態
+   * @param [in]      radius    ステンシルの幅 r
+   * @param [in]      steps     1回の通信で進めるステップ数 s
+   * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
    * @retval true-success, false-fail
+   * @note s*rは袖の幅halo_width以下とする。cellのみ
    */
-  template <class T>
-  bool Comm_V_node(T* src, const int gc_comm, MPI_Request *req);
+  bool setCommDeep(CommDeep* dp, const int radius, const int steps, const int num_compo=1);
+
 
-  
   /* #########################################################
-   * @brief ベクトル変数 cell
-   * @param [in,out]  src     ベクトル変数
-   * @param [in]      gc_comm 実際に通信する通信面数
-   * @param [in,out]  req     MPI_Request
+   * @brief 1ステップ分の袖の準備と計算領域の取得
+   * @param [in,out]  dp    通信回避の状態
+   * @param [in,out]  src   通信する配列
    * @retval true-success, false-fail
+   * @note 有効な袖がr層未満のときのみs*r層を通信し、dp->st, dp->edに
+   *       このステップで計算する領域を返す
    */
   template <class T>
-  bool Comm_V_cell(T* src, const int gc_comm, MPI_Request *req);
-  
-  
+  bool Comm_deep(CommDeep* dp, T* src);
+
+
+
+// CB_CommSimd.cpp
+public:
+
   /* #########################################################
-   * @brief ベクトル変数 node
-   * @param [in,out]  dest    ベクトル変数
-   * @param [in]      gc_comm 実際に通信する通信面数
-   * @param [out]     req     Array of MPI request
-   * @retval true-success, false-fail
+   * @brief X面のpack, unpackに使う命令セットの設定
+   * @param [in] level  SIMDlevel
+   * @retval true-success, false-このCPUでは使えない
+   * @note 既定は実行時にCPUから判定する。全ての通信クラスで共通
+   */
+  static bool setSimdLevel(const int level);
+
+
+  /* #########################################################
+   * @brief X面のpack, unpackに使う命令セット
+   * @retval SIMDlevel
+   */
+  static int getSimdLevel();
+
+
+private:
+
+  /*
+   * @brief i方向にlen要素の行をnrow行、連続したバッファへ集める
+   * @param [in]  src   先頭行の先頭
+   * @param [in]  ss    行の間隔（要素数）
+   * @param [out] dst   バッファ
+   * @param [in]  len   1行の要素数（X面では通信面数）
+   * @param [in]  nrow  行数
    */
   template <class T>
-  bool Comm_V_wait_node(T* dest, const int gc_comm, MPI_Request *req);
+  static void pack_Rows(const T* src, const int ss, T* dst, const int len, const int nrow);
+
+
+  /*
+   * @brief 連続したバッファから、i方向にlen要素の行をnrow行へ配る
+   * @param [in]  src   バッファ
+   * @param [out] dst   先頭行の先頭
+   * @param [in]  ds    行の間隔（要素数）
+   * @param [in]  len   1行の要素数（X面では通信面数）
+   * @param [in]  nrow  行数
+   */
+  template <class T>
+  static void unpack_Rows(const T* src, T* dst, const int ds, const int len, const int nrow);
+
+
+
+// CB_CommThreshold.cpp
+public:
 
-  
   /* #########################################################
-   * @brief ベクトル変数 cell
-   * @param [in,out]  dest    ベクトル変数
-   * @param [in]      gc_comm 実際に通信する通信面数
-   * @param [out]     req     Array of MPI request
+   * @brief pack, unpackを並列に処理する最小の大きさの設定
+   * @param [in] bytes  1回のpack, unpackの大きさ（バイト）、0は常に並列
    * @retval true-success, false-fail
+   * @note 既定は最初のinit()で計測して決める。全ての通信クラスで共通
    */
-  template <class T>
-  bool Comm_V_wait_cell(T* dest, const int gc_comm, MPI_Request *req);
+  static bool setParallelThreshold(const long bytes);
+
+
+  /* #########################################################
+   * @brief pack, unpackを並列に処理する最小の大きさ
+   * @retval バイト数、負は未設定（常に並列）
+   */
+  static long getParallelThreshold();
+
+
+private:
+
+  /*
+   * @brief 閾値が未設定なら、環境変数 CB_PACK_PAR_BYTES または計測で決める
+   */
+  static void calibrateThreshold();
+
+
+  /*
+   * @brief 並列領域を開始するか
+   * @param [in] bytes  1回のpack, unpackの大きさ（バイト）
+   */
+  static bool isParallelPack(const size_t bytes);
+
+
+  /*
+   * @brief 呼び出したスレッドのpack, unpackを逐次とする
+   * @param [in] flag  true-逐次, false-閾値による
+   */
+  static void setSerialPack(const bool flag);
+
+
+
+// CB_PackingBox.h
+private:
   
+  template <class T, class U>
+  void pack_Box(const T *array,
+                const int nc,
+                const CommBox *b,
+                U *sendbuf);
+  
+  template <class T, class U>
+  void unpack_Box(T *array,
+                  const int nc,
+                  const CommBox *b,
+                  const U *recvbuf);
+
+  template <int N, class T, class U>
+  void pack_BoxN(const T *array,
+                 const int nc,
+                 const CommBox *b,
+                 U *sendbuf);
+
+  template <int N, class T, class U>
+  void unpack_BoxN(T *array,
+                   const int nc,
+                   const CommBox *b,
+                   const U *recvbuf);
+
+  void getBoxRows(const int* st,
+                  const int* ed,
+                  const int nc,
+                  size_t* rows,
+                  size_t* rlen) const;
+
+  size_t getBoxRowOffset(const int* st,
+                         const int* ed,
+                         const int nc,
+                         const size_t r) const;
 
+  template <class T>
+  void pack_BoxRows(const T *array,
+                    const int nc,
+                    const CommBox *b,
+                    const size_t r0,
+                    const size_t r1,
+                    T *buf);
+
+  template <class T>
+  void unpack_BoxRows(T *array,
+                      const int nc,
+                      const CommBox *b,
+                      const size_t r0,
+                      const size_t r1,
+                      const T *buf);
+
+  template <class T>
+  bool pack_Boxes(const T *array,
+                  const int nc,
+                  const int n,
+                  const CommBox* const* b,
+                  T* const* buf,
+                  const int* dir,
+                  MPI_Request* const* req);
+
+  template <class T>
+  void unpack_Boxes(T *array,
+                    const int nc,
+                    const int n,
+                    const CommBox* const* b,
+                    const T* const* buf);
+
+  template <class T>
+  void copy_Box(T *array,
+                const int nc,
+                const CommBox *r,
+                const CommBox *s);
+
+  template <class T>
+  void copy_Self(T *array,
+                 const int nc,
+                 const unsigned self,
+                 const CommBox *box);
+  
+  
+  
+  
   
   
 // CB_PackingScalarCell.cpp
@@ -747,6 +2137,7 @@ private:
                      const T *recvbuf);
 #endif // _DIAGONAL_COMM
   
+  
 };
 
 
@@ -756,5 +2147,6 @@ private:
 #include "CB_PackingScalarNode.h"
 #include "CB_PackingVectorCell.h"
 #include "CB_PackingVectorNode.h"
+#include "CB_PackingBox.h"
 
 #endif // _CB_COMM_H_
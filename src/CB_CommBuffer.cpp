@@ -0,0 +1,230 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommBuffer.cpp
+ * @brief  BrickComm class, communication buffer arena
+ * @note   全方向の送受信バッファを、ページ境界に確保した1つの領域から
+ *         CB_BUF_ALIGN境界で切り出す
+ *         ページはpack_Boxes()と同じく全体を連続に等分したスレッドで最初に書き込み
+ *         (first touch)、各スレッドに近いメモリに置く（packの分割の近似）
+ *         要素は8バイトとし、型の大きさと成分数の確認はisBufCompo()のみで行う
+ */
+
+#include "CB_Comm.h"
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+
+// #############################################################
+// alignの倍数に切り上げ
+static inline size_t alignUp(const size_t n, const size_t align)
+{
+  return (n + align - 1) / align * align;
+}
+
+
+// #############################################################
+/*
+ * @brief 通信バッファの確保方法の設定
+ * @param [in] m_opt BUFoptionの組み合わせ
+ * @retval true-success, false-fail
+ */
+bool BrickComm::setBufOption(const unsigned m_opt)
+{
+  if ( m_opt & ~(unsigned)(BUF_MPIMEM | BUF_HUGEPAGE) ) {
+    printf("Error : Invalid buffer option [%u]\n", m_opt);
+    return false;
+  }
+
+  if ( buf_flag == 1 ) {
+    printf("Error : setBufOption() must be called before init()\n");
+    return false;
+  }
+
+  buf_opt = m_opt;
+  return true;
+}
+
+
+// #############################################################
+/*
+ * @brief 全方向の通信バッファを1つの領域から切り出して確保
+ * @param [in] num_compo 成分数
+ * @retval true-success, false-fail
+ * @note バッファの要素は8バイト（全ての型で共用）
+ *       COMM_SWEEP (buf_sweep) では面に先の軸の袖を含めるので、Y面はX方向、
+ *       Z面はX, Y方向の袖を含む大きさとする
+ */
+bool BrickComm::allocBuffer(const int num_compo)
+{
+  int gc = halo_width;
+  int ex = buf_sweep ? 2*gc : 0;
+
+  // 要素数
+  size_t f_sz[3];
+  f_sz[0] = (size_t)size[1] * size[2] * gc * num_compo;
+  f_sz[1] = (size_t)(size[0]+ex) * size[2] * gc * num_compo;
+  f_sz[2] = (size_t)(size[0]+ex) * (size[1]+ex) * gc * num_compo;
+
+#ifdef _DIAGONAL_COMM
+  const int nb = 16;
+#else
+  const int nb = 12;
+#endif
+
+  double** ptr[16] = { &f_ims, &f_imr, &f_ips, &f_ipr,
+                       &f_jms, &f_jmr, &f_jps, &f_jpr,
+                       &f_kms, &f_kmr, &f_kps, &f_kpr,
+#ifdef _DIAGONAL_COMM
+                       &f_es,  &f_er,  &f_cs,  &f_cr
+#else
+                       NULL, NULL, NULL, NULL
+#endif
+                     };
+
+  size_t len[16];
+  for (int n=0; n<12; n++) len[n] = f_sz[n/4];
+
+#ifdef _DIAGONAL_COMM
+  // edge
+  size_t lx = (size_t)size[0] * gc * gc * num_compo;
+  size_t ly = (size_t)size[1] * gc * gc * num_compo;
+  size_t lz = (size_t)size[2] * gc * gc * num_compo;
+  len[12] = len[13] = lx*4 + ly*4 + lz*4;
+
+  // corner
+  len[14] = len[15] = (size_t)gc * gc * gc * num_compo * 8;
+#endif
+
+  // 方向ごとの位置
+  size_t ofs[16];
+  size_t total = 0;
+  for (int n=0; n<nb; n++) {
+    ofs[n] = total;
+    total += alignUp(len[n] * sizeof(double), CB_BUF_ALIGN);
+  }
+
+  size_t page = ( buf_opt & BUF_HUGEPAGE ) ? CB_HUGE_PAGE_SIZE : CB_PAGE_SIZE;
+  total = alignUp(total, page);
+
+  // 先頭をページ境界に揃えるため、1ページ分多く確保
+  char* raw = NULL;
+  if ( buf_opt & BUF_MPIMEM ) {
+    if ( MPI_SUCCESS != MPI_Alloc_mem((MPI_Aint)(total + page), MPI_INFO_NULL, &raw) ) return false;
+  }
+  else {
+    if ( !(raw = (char*)malloc(total + page)) ) return false;
+  }
+  f_raw = raw;
+
+  char* base = (char*)alignUp((size_t)raw, page);
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if ( buf_opt & BUF_HUGEPAGE ) madvise(base, total, MADV_HUGEPAGE);
+#endif
+
+  for (int n=0; n<nb; n++) *ptr[n] = (double*)(base + ofs[n]);
+
+  // first touch
+  // pack_Boxes()と同じく、全バッファを1つの並列領域で連続に等分し、スレッド0が末尾を受け持つ
+  // packの行の分割は通信面数、成分数で変わり、受信バッファも含むので、近似の配置となる
+  double* p = (double*)base;
+  size_t m = total / sizeof(double);
+
+#pragma omp parallel
+  {
+    int tid = 0;
+    int np  = 1;
+#ifdef _OPENMP
+    tid = omp_get_thread_num();
+    np  = omp_get_num_threads();
+#endif
+    int w = (tid + np - 1) % np;
+    size_t lo = m * w / np;
+    size_t hi = m * (w+1) / np;
+    for (size_t i=lo; i<hi; i++) p[i] = 0.0;
+  }
+
+  return true;
+}
+
+
+// #############################################################
+/*
+ * @brief 面のバッファをCOMM_SWEEPの大きさで確保し直す
+ * @retval true-success, false-fail
+ * @note setCommMode(COMM_SWEEP), setCommDeep()から呼ぶ
+ *       確保し直すのは自ランクのバッファのみ（受信ウィンドウはそのまま）
+ */
+bool BrickComm::allocSweepBuffer()
+{
+  if ( grid_type == "node" ) {
+    printf("Error : COMM_SWEEP is supported only for cell\n");
+    return false;
+  }
+
+  if ( buf_sweep ) return true;
+
+  if ( comm_active ) {
+    printf("Error : buffers cannot be reallocated during a halo exchange\n");
+    return false;
+  }
+
+  buf_sweep = 1;
+
+  // init()前は、init()で確保する
+  if ( buf_flag != 1 ) return true;
+
+  int nc = buf_compo;
+  freeBuffer();
+  if ( !allocBuffer(nc) ) return false;
+
+  buf_flag = 1;
+  buf_compo = nc;
+
+  return true;
+}
+
+
+// #############################################################
+// 通信バッファの解放
+void BrickComm::freeBuffer()
+{
+  // 大きさはbuf_compoによる
+  freeZipBuffer();
+
+  if ( f_raw ) {
+    if ( buf_opt & BUF_MPIMEM ) {
+      // MPI_Finalize()後は解放しない
+      int flag = 0;
+      MPI_Finalized(&flag);
+      if ( !flag ) MPI_Free_mem(f_raw);
+    }
+    else {
+      free(f_raw);
+    }
+  }
+
+  f_raw = NULL;
+  buf_flag = 0;
+  buf_compo = 0;
+
+  f_ims = f_imr = f_ips = f_ipr = NULL;
+  f_jms = f_jmr = f_jps = f_jpr = NULL;
+  f_kms = f_kmr = f_kps = f_kpr = NULL;
+#ifdef _DIAGONAL_COMM
+  f_es = f_er = f_cs = f_cr = NULL;
+#endif
+}
@@ -0,0 +1,160 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommDeep.cpp
+ * @brief  BrickComm class, communication-avoiding deep halo
+ * @note   幅rのステンシルで、s*r層の袖をsステップに1回だけ通信する
+ *         途中のステップは隣接ランクの内点を袖の中まで重複して計算し、
+ *         計算領域はステップごとにr層ずつ狭くなる
+ *         通信回数は1/sとなり、重複計算が増える
+ *         辺・点の袖も使うので、X, Y, Zの順の面の通信(Comm_sweep)で埋める
+ *
+ *   CommDeep dp;
+ *   CM.setCommDeep(&dp, 1, 4);
+ *   for (step) {
+ *     CM.Comm_deep(&dp, q);
+ *     kernel(dp.st, dp.ed);    // st, edの全体を更新する
+ *   }
+ *
+ *   隣接ランクのない面の袖は、計算領域の外として扱う
+ *   境界条件を毎ステップ与える場合は、計算領域の広がった軸の袖の範囲まで与える
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief 深い袖による通信回避の設定
+ * @param [out]     dp        通信回避の状態
+ * @param [in]      radius    ステンシルの幅 r
+ * @param [in]      steps     1回の通信で進めるステップ数 s
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @retval true-success, false-fail
+ * @note nodeは隣接ランクと内点を共有するので対象外
+ */
+bool BrickComm::setCommDeep(CommDeep* dp,
+                            const int radius,
+                            const int steps,
+                            const int num_compo)
+{
+  if ( !dp || buf_flag != 1 ) return false;
+  if ( num_compo < 1 || num_compo > buf_compo ) return false;
+
+  if ( grid_type != "cell" ) {
+    printf("Error : Deep halo is supported only for cell\n");
+    return false;
+  }
+
+  if ( radius < 1 || steps < 1 || radius * steps > halo_width ) {
+    printf("Error : radius*steps (%d*%d) must be in [1, %d]\n", radius, steps, halo_width);
+    return false;
+  }
+
+  // Comm_sweep()の面のバッファ
+  if ( !allocSweepBuffer() ) return false;
+
+  dp->r = radius;
+  dp->s = steps;
+  dp->gc = radius * steps;
+  dp->num_compo = num_compo;
+  dp->valid = 0;
+  dp->n_comm = 0;
+  dp->n_step = 0;
+
+  for (int m=0; m<3; m++) {
+    dp->st[m] = 0;
+    dp->ed[m] = size[m];
+  }
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_deep(CommDeep* dp, float* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, double* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, int* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, unsigned* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, long long* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, signed char* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, unsigned char* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, short* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, CB_half* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, CB_bf16* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, std::complex<float>* src);
+
+template
+bool BrickComm::Comm_deep(CommDeep* dp, std::complex<double>* src);
+
+
+/* #########################################################
+ * @brief 1ステップ分の袖の準備と計算領域の取得
+ * @param [in,out]  dp    通信回避の状態
+ * @param [in,out]  src   通信する配列
+ * @retval true-success, false-fail
+ * @note 計算後の値は、計算領域をr層狭めた範囲まで正しいので、
+ *       呼び出すごとに有効な袖をr層減らす
+ *       計算領域は、隣接ランクのある側を有効な袖の層数まで広げる
+ */
+template <class T>
+bool BrickComm::Comm_deep(CommDeep* dp, T* src)
+{
+  if ( !dp || !src || dp->r < 1 ) return false;
+
+  // setCommDeep()の後にinit(), setBrickComm()で変わった場合
+  if ( buf_flag != 1 || dp->gc > halo_width || !isBufCompo(src, dp->num_compo) ) return false;
+
+  if ( dp->valid < dp->r ) {
+    MPI_Request req[NOFACE*2];
+
+    if ( !Comm_sweep(src, dp->gc, dp->num_compo, req) ) return false;
+    if ( !Comm_sweep_wait(src, dp->gc, dp->num_compo, req) ) return false;
+
+    dp->valid = dp->gc;
+    dp->n_comm++;
+  }
+
+  dp->valid -= dp->r;
+
+  int e = dp->valid;
+
+  for (int m=0; m<3; m++) {
+    dp->st[m] = ( comm_tbl[2*m]   >= 0 ) ? -e : 0;
+    dp->ed[m] = ( comm_tbl[2*m+1] >= 0 ) ? size[m] + e : size[m];
+  }
+
+  dp->n_step++;
+
+  return true;
+}
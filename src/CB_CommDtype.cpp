@@ -0,0 +1,266 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommDtype.cpp
+ * @brief  BrickComm class, halo exchange with MPI derived datatypes
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief 派生データ型の送受信領域
+ * @param [in]  dir 方向 (DIRection)
+ * @param [in]  gc  通信する袖の層数
+ * @param [out] b   送受信領域
+ * @note 全方向の受信を配列上で同時に待つので、受信領域どうし、受信領域と
+ *       送信領域が重ならないようにする（重なるとMPIの誤り）
+ *       cellはsetCommBox()のまま。nodeは共有する節点0を受信せず、
+ *       受信 [1-gc, 0), [N, N+gc)  送信 [1, 1+gc), [N-gc, N-1)  オフセット0の軸は[0, N)
+ *       （gc=1の面はsetCommBox()と同じ [-1, 0) <- [N-2, N-1)、
+ *         gc=1の辺・点は負の側の受信、正の側の送信が空となる）
+ *       共有する節点は両側で同じ値を持つので、受信しなくても結果は変わらない
+ */
+void BrickComm::setCommBox_Dtype(const int dir, const int gc, CommBox* b)
+{
+  setCommBox(dir, gc, b);
+
+  if ( grid_type != "node" ) return;
+
+  int o[3];
+  getDirOffset(dir, o);
+
+  bool face = (dir < 6);
+
+  for (int m=0; m<3; m++) {
+    int N = size[m];
+
+    if ( o[m] == 0 ) {
+      b->s_st[m] = b->r_st[m] = 0;
+      b->s_ed[m] = b->r_ed[m] = N;
+    }
+    else if ( face && gc == 1 ) {
+      continue;
+    }
+    else if ( o[m] < 0 ) {
+      b->r_ed[m] = 0;
+    }
+    else {
+      b->s_ed[m] = N-1;
+    }
+  }
+
+  b->len = (b->s_ed[0] - b->s_st[0]) * (b->s_ed[1] - b->s_st[1]) * (b->s_ed[2] - b->s_st[2]);
+}
+
+
+// #############################################################
+/*
+ * @brief 派生データ型をキャッシュから取得、なければ作成
+ * @param [in] base 要素の型
+ * @param [in] gc   通信する袖の層数
+ * @param [in] nc   成分数
+ * @note 配列全体を(nc, NK+2VC, NJ+2VC, NI+2VC)の4次元配列とみなし、
+ *       setCommBox_Dtype()の送受信領域をMPI_Type_create_subarrayで表す
+ *       領域が空の型（nodeのgc=1の辺・点の一部）はMPI_DATATYPE_NULLとする
+ *       K面の平面は、成分ごとに連続なgc枚の平面をMPI_Type_vectorで表す
+ *       LAYOUT_AOSでは(NK+2VC, NJ+2VC, NI+2VC, nc)とし、K面の平面は連続となる
+ *       キャッシュが一杯のときは古いものから置き換える
+ *       通信中の型を解放しても、MPIは通信完了まで型を保持する
+ */
+CommDtype* BrickComm::getCommType(MPI_Datatype base, const int gc, const int nc)
+{
+  // 1成分は並びによらない
+  int layout = ( nc > 1 ) ? vec_layout : LAYOUT_SOA;
+
+  for (int i=0; i<CB_DTYPE_CACHE; i++) {
+    CommDtype* t = &dt_cache[i];
+    if ( t->base == base && t->gc == gc && t->nc == nc && t->layout == layout ) return t;
+  }
+
+  CommDtype* t = &dt_cache[dt_next];
+  dt_next = (dt_next+1) % CB_DTYPE_CACHE;
+  t->clear();
+
+  int VC = halo_width;
+
+  // 成分の次元  SOA-0, AOS-3
+  int c = ( layout == LAYOUT_AOS ) ? 3 : 0;
+  int o = ( layout == LAYOUT_AOS ) ? 0 : 1;
+
+  int sizes[4], subsizes[4], starts[4];
+  sizes[c]   = nc;
+  sizes[o]   = size[2] + 2*VC;
+  sizes[o+1] = size[1] + 2*VC;
+  sizes[o+2] = size[0] + 2*VC;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox_Dtype(dir, gc, &b);
+
+    // send
+    subsizes[c]   = nc;
+    subsizes[o]   = b.s_ed[2] - b.s_st[2];
+    subsizes[o+1] = b.s_ed[1] - b.s_st[1];
+    subsizes[o+2] = b.s_ed[0] - b.s_st[0];
+    starts[c]   = 0;
+    starts[o]   = b.s_st[2] + VC;
+    starts[o+1] = b.s_st[1] + VC;
+    starts[o+2] = b.s_st[0] + VC;
+
+    if ( subsizes[0] * subsizes[1] * subsizes[2] * subsizes[3] > 0 ) {
+      if ( MPI_SUCCESS != MPI_Type_create_subarray(4, sizes, subsizes, starts,
+                                                   MPI_ORDER_C, base,
+                                                   &t->s_type[dir]) ) return NULL;
+      if ( MPI_SUCCESS != MPI_Type_commit(&t->s_type[dir]) ) return NULL;
+    }
+
+    // recv
+    subsizes[o]   = b.r_ed[2] - b.r_st[2];
+    subsizes[o+1] = b.r_ed[1] - b.r_st[1];
+    subsizes[o+2] = b.r_ed[0] - b.r_st[0];
+    starts[o]   = b.r_st[2] + VC;
+    starts[o+1] = b.r_st[1] + VC;
+    starts[o+2] = b.r_st[0] + VC;
+
+    if ( subsizes[0] * subsizes[1] * subsizes[2] * subsizes[3] > 0 ) {
+      if ( MPI_SUCCESS != MPI_Type_create_subarray(4, sizes, subsizes, starts,
+                                                   MPI_ORDER_C, base,
+                                                   &t->r_type[dir]) ) return NULL;
+      if ( MPI_SUCCESS != MPI_Type_commit(&t->r_type[dir]) ) return NULL;
+    }
+  }
+
+  // 袖を含むK方向の平面
+  int plane  = sizes[o+2] * sizes[o+1] * gc;
+  int stride = sizes[o+2] * sizes[o+1] * sizes[o];
+
+  if ( layout == LAYOUT_AOS ) {
+    if ( MPI_SUCCESS != MPI_Type_contiguous(plane * nc, base, &t->k_plane) ) return NULL;
+  }
+  else {
+    if ( MPI_SUCCESS != MPI_Type_vector(nc, plane, stride, base, &t->k_plane) ) return NULL;
+  }
+  if ( MPI_SUCCESS != MPI_Type_commit(&t->k_plane) ) return NULL;
+
+  t->base   = base;
+  t->gc     = gc;
+  t->nc     = nc;
+  t->layout = layout;
+
+  return t;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_dtype(float* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(double* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(int* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(long long* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(short* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_dtype(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief 派生データ型による袖通信の開始
+ * @param [in,out]  src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note 受信は送信側の方向をタグとする
+ *       受信領域は重ならない (setCommBox_Dtype())、領域が空の型は送受信しない
+ */
+template <class T>
+bool BrickComm::Comm_dtype(T* src,
+                           const int gc_comm,
+                           const int num_compo,
+                           MPI_Request *req)
+{
+  if ( !src || !req ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width || num_compo < 1 ) return false;
+
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+
+  CommDtype* t = getCommType(GetMPI_Datatype(src), gc_comm, num_compo);
+  if ( !t ) return false;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    int nID = comm_tbl[dir];
+    if ( nID < 0 || t->r_type[dir] == MPI_DATATYPE_NULL ) continue;
+
+    if ( MPI_SUCCESS != MPI_Irecv(src,
+                                  1,
+                                  t->r_type[dir],
+                                  nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[dir*2]) ) return false;
+  }
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    int nID = comm_tbl[dir];
+    if ( nID < 0 || t->s_type[dir] == MPI_DATATYPE_NULL ) continue;
+
+    if ( MPI_SUCCESS != MPI_Isend(src,
+                                  1,
+                                  t->s_type[dir],
+                                  nID,
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &req[dir*2+1]) ) return false;
+  }
+
+  return true;
+}
+
+
+// #############################################################
+// 派生データ型による袖通信の完了待ち
+bool BrickComm::Comm_dtype_wait(MPI_Request *req)
+{
+  if ( !req ) return false;
+
+  if ( MPI_SUCCESS != MPI_Waitall(NOFACE*2, req, MPI_STATUSES_IGNORE) ) return false;
+
+  return true;
+}
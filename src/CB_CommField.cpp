@@ -0,0 +1,192 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommField.cpp
+ * @brief  BrickComm class, aggregated halo exchange of multiple arrays
+ * @note   隣接方向ごとに登録された全配列を1つのバッファにpackし、MPI_BYTEの
+ *         1メッセージで送受信する
+ *         バッファ上の並びは、要素のバイト数の大きい配列から順に、登録順とする
+ *         （各配列の先頭のアラインメントを保つため）
+ */
+
+#include "CB_Comm.h"
+
+
+// 要素のバイト数の並び
+static const int field_esz[5] = {16, 8, 4, 2, 1};
+
+
+// #############################################################
+/*
+ * @brief 全配列のpack
+ * @param [in]  fl  配列のリスト
+ * @param [in]  b   送受信領域
+ * @param [out] buf 送信バッファ
+ */
+void BrickComm::pack_Fields(const CommFieldList* fl, const CommBox* b, char* buf)
+{
+  size_t ofs = 0;
+
+  for (int e=0; e<5; e++) {
+    for (int n=0; n<fl->num; n++) {
+      if ( fl->esz[n] != field_esz[e] ) continue;
+
+      int nc = fl->nc[n];
+      char* p = buf + ofs;
+
+      // 要素はビット列のまま、同じバイト数の型でコピーする
+      switch ( fl->esz[n] ) {
+        case 16: pack_Box((const std::complex<double>*)fl->ptr[n], nc, b, (std::complex<double>*)p); break;
+        case 8:  pack_Box((const long long*)fl->ptr[n],            nc, b, (long long*)p);            break;
+        case 4:  pack_Box((const unsigned*)fl->ptr[n],             nc, b, (unsigned*)p);             break;
+        case 2:  pack_Box((const unsigned short*)fl->ptr[n],       nc, b, (unsigned short*)p);       break;
+        case 1:  pack_Box((const unsigned char*)fl->ptr[n],        nc, b, (unsigned char*)p);        break;
+      }
+
+      ofs += (size_t)b->len * nc * fl->esz[n];
+    }
+  }
+}
+
+
+// #############################################################
+/*
+ * @brief 全配列のunpack
+ * @param [in,out] fl  配列のリスト
+ * @param [in]     b   送受信領域
+ * @param [in]     buf 受信バッファ
+ */
+void BrickComm::unpack_Fields(CommFieldList* fl, const CommBox* b, const char* buf)
+{
+  size_t ofs = 0;
+
+  for (int e=0; e<5; e++) {
+    for (int n=0; n<fl->num; n++) {
+      if ( fl->esz[n] != field_esz[e] ) continue;
+
+      int nc = fl->nc[n];
+      const char* p = buf + ofs;
+
+      switch ( fl->esz[n] ) {
+        case 16: unpack_Box((std::complex<double>*)fl->ptr[n], nc, b, (const std::complex<double>*)p); break;
+        case 8:  unpack_Box((long long*)fl->ptr[n],            nc, b, (const long long*)p);            break;
+        case 4:  unpack_Box((unsigned*)fl->ptr[n],             nc, b, (const unsigned*)p);             break;
+        case 2:  unpack_Box((unsigned short*)fl->ptr[n],       nc, b, (const unsigned short*)p);       break;
+        case 1:  unpack_Box((unsigned char*)fl->ptr[n],        nc, b, (const unsigned char*)p);        break;
+      }
+
+      ofs += (size_t)b->len * nc * fl->esz[n];
+    }
+  }
+}
+
+
+// #############################################################
+/*
+ * @brief 複数の配列の集約袖通信の開始
+ * @param [in,out]  fl        配列のリスト
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note 受信は送信側の方向をタグとする
+ */
+bool BrickComm::Comm_fields(CommFieldList* fl,
+                            const int gc_comm,
+                            MPI_Request *req)
+{
+  if ( !fl || !req || buf_flag != 1 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( fl->num < 1 ) return false;
+
+  // バッファはinit()の成分数 x 8バイトで確保されている
+  size_t bytes = fl->getBytes();
+  if ( bytes > sizeof(double) * buf_compo ) {
+    printf("Error : Comm_fields() needs init(%d) or more\n",
+           (int)((bytes + sizeof(double) - 1) / sizeof(double)));
+    return false;
+  }
+
+  // 送受信バッファはComm_S_*, Comm_V_*などと共有する
+  if ( comm_active ) {
+    printf("Error : another halo exchange is in progress (call the wait first)\n");
+    return false;
+  }
+
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    char *sb, *rb;
+    if ( !getDirBuf(dir, &sb, &rb) ) return false;
+
+    int sz = (int)(b.len * bytes);
+
+    if ( MPI_SUCCESS != MPI_Irecv(rb,
+                                  sz,
+                                  MPI_BYTE,
+                                  b.nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[dir*2]) ) return false;
+
+    pack_Fields(fl, &b, sb);
+
+    if ( MPI_SUCCESS != MPI_Isend(sb,
+                                  sz,
+                                  MPI_BYTE,
+                                  b.nID,
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &req[dir*2+1]) ) return false;
+  }
+
+  comm_active = 1;
+
+  return true;
+}
+
+
+// #############################################################
+/*
+ * @brief 複数の配列の集約袖通信の完了待ち
+ * @param [in,out]  fl        配列のリスト
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ */
+bool BrickComm::Comm_fields_wait(CommFieldList* fl,
+                                 const int gc_comm,
+                                 MPI_Request *req)
+{
+  if ( !fl || !req ) return false;
+
+  comm_active = 0;
+
+  if ( MPI_SUCCESS != MPI_Waitall(NOFACE*2, req, MPI_STATUSES_IGNORE) ) return false;
+
+  // 面, 辺, 点の順
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    char *sb, *rb;
+    if ( !getDirBuf(dir, &sb, &rb) ) return false;
+
+    unpack_Fields(fl, &b, rb);
+  }
+
+  return true;
+}
@@ -0,0 +1,404 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommKface.cpp
+ * @brief  BrickComm class, halo exchange sending whole K-planes without packing
+ * @note   K面は袖を含むgc枚の平面がメモリ上で連続（ベクトルは成分ごとに連続）なので、
+ *         pack/unpackせずに配列から直接送受信する
+ *         X, Y方向の袖を先に更新してからK面を送受信するので、K方向の辺・点の袖も
+ *         K面の平面に含まれて更新される
+ *         K面の受信は開始時に出し (cell)、K面の送信はX, Y方向のunpackの直後に出す
+ *         （waitの前にprogress()を呼ぶと、X, Y方向の受信が揃った時点で送信する）
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief 方向ごとの送受信バッファ
+ * @param [in]  dir 方向
+ * @param [out] sb  送信バッファ
+ * @param [out] rb  受信バッファ
+ * @note 面はf_ims, ..., 辺はf_es, f_er、点はf_cs, f_crのinit()で確保した大きさの
+ *       方向ごとの固定位置を返す
+ *       辺の並びはi方向(E_mYmZ-E_pYpZ), j方向(E_mXmZ-E_pXpZ), k方向(E_mXmY-E_pXpY)
+ */
+bool BrickComm::getDirBuf(const int dir, char** sb, char** rb)
+{
+  if ( buf_flag != 1 ) return false;
+
+  switch (dir)
+  {
+    case I_minus:
+      *sb = (char*)f_ims;
+      *rb = (char*)f_imr;
+      return true;
+
+    case I_plus:
+      *sb = (char*)f_ips;
+      *rb = (char*)f_ipr;
+      return true;
+
+    case J_minus:
+      *sb = (char*)f_jms;
+      *rb = (char*)f_jmr;
+      return true;
+
+    case J_plus:
+      *sb = (char*)f_jps;
+      *rb = (char*)f_jpr;
+      return true;
+
+    case K_minus:
+      *sb = (char*)f_kms;
+      *rb = (char*)f_kmr;
+      return true;
+
+    case K_plus:
+      *sb = (char*)f_kps;
+      *rb = (char*)f_kpr;
+      return true;
+  }
+
+#ifdef _DIAGONAL_COMM
+  int gc = halo_width;
+  size_t lx = size[0] * gc * gc * buf_compo;
+  size_t ly = size[1] * gc * gc * buf_compo;
+  size_t lz = size[2] * gc * gc * buf_compo;
+  size_t lc = gc * gc * gc * buf_compo;
+
+  // edge
+  if ( dir >= E_mYmZ && dir <= E_pXpY ) {
+    size_t ofs;
+    if      ( dir <= E_pYpZ ) ofs = (dir-E_mYmZ) * lx;
+    else if ( dir <= E_pXpZ ) ofs = lx*4 + (dir-E_mXmZ) * ly;
+    else                      ofs = lx*4 + ly*4 + (dir-E_mXmY) * lz;
+    *sb = (char*)(f_es + ofs);
+    *rb = (char*)(f_er + ofs);
+    return true;
+  }
+
+  // corner
+  if ( dir >= C_mXmYmZ && dir <= C_pXpYpZ ) {
+    size_t ofs = (dir-C_mXmYmZ) * lc;
+    *sb = (char*)(f_cs + ofs);
+    *rb = (char*)(f_cr + ofs);
+    return true;
+  }
+#endif
+
+  return false;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_kface(float* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(double* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(int* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(long long* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(short* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief K面の平面を直接送受信する袖通信の開始
+ * @param [in,out]  src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note X, Y方向の面（斜め通信ではXY辺も）をpackして送受信を開始する
+ *       cellのK面の受信領域 (k<0, k>=N) はX, Y方向のunpack、送信と重ならないので、
+ *       K面の受信もここで開始する。nodeのK面の受信領域は共有する節点k=0を含み、
+ *       X, Y方向の送受信と重なるので、送信と同じくX, Y方向のunpack後に開始する
+ */
+template <class T>
+bool BrickComm::Comm_kface(T* src,
+                           const int gc_comm,
+                           const int num_compo,
+                           MPI_Request *req)
+{
+  if ( !src || !req || buf_flag != 1 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( !isBufCompo(src, num_compo) ) return false;
+
+  MPI_Datatype dtype = GetMPI_Datatype(src);
+
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+  kf_posted = 0;
+
+  // K面の受信
+  if ( grid_type == "cell" ) {
+    CommDtype* t = getCommType(dtype, gc_comm, num_compo);
+    if ( !t ) return false;
+
+    for (int dir=K_minus; dir<=K_plus; dir++) {
+      CommBox b;
+      setCommBox_K(dir, gc_comm, &b);
+      if ( b.nID < 0 ) continue;
+
+      if ( MPI_SUCCESS != MPI_Irecv(&src[getVecOffset(b.r_st[0], b.r_st[1], b.r_st[2], num_compo)],
+                                    1,
+                                    t->k_plane,
+                                    b.nID,
+                                    getTag(getOppositeDir(dir)),
+                                    mpi_comm,
+                                    &req[dir*2]) ) return false;
+    }
+  }
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    int o[3];
+    getDirOffset(dir, o);
+    if ( o[2] != 0 ) continue;
+
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    int sz = b.len * num_compo;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+    T* sb = (T*)cs;
+    T* rb = (T*)cr;
+
+    if ( MPI_SUCCESS != MPI_Irecv(rb,
+                                  sz,
+                                  dtype,
+                                  b.nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[dir*2]) ) return false;
+
+    pack_Box(src, num_compo, &b, sb);
+
+    if ( MPI_SUCCESS != MPI_Isend(sb,
+                                  sz,
+                                  dtype,
+                                  b.nID,
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &req[dir*2+1]) ) return false;
+  }
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::kface_Post(float* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(double* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(int* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(short* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::kface_Post(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief X, Y方向の受信を待ってunpackし、K面の送信を開始
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note K面の平面はX, Y方向の袖を含むので、送信はunpackの後とする
+ *       2回目以降の呼び出しは何もしない
+ */
+template <class T>
+bool BrickComm::kface_Post(T* dest,
+                           const int gc_comm,
+                           const int num_compo,
+                           MPI_Request *req)
+{
+  if ( kf_posted ) return true;
+
+  // X, Y方向
+  for (int dir=0; dir<NOFACE; dir++) {
+    int o[3];
+    getDirOffset(dir, o);
+    if ( o[2] != 0 ) continue;
+
+    if ( MPI_SUCCESS != MPI_Wait(&req[dir*2], MPI_STATUS_IGNORE) ) return false;
+  }
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    int o[3];
+    getDirOffset(dir, o);
+    if ( o[2] != 0 ) continue;
+
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+    T* rb = (T*)cr;
+
+    unpack_Box(dest, num_compo, &b, rb);
+  }
+
+
+  // K面
+  CommDtype* t = getCommType(GetMPI_Datatype(dest), gc_comm, num_compo);
+  if ( !t ) return false;
+
+  for (int dir=K_minus; dir<=K_plus; dir++) {
+    CommBox b;
+    setCommBox_K(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    if ( grid_type != "cell" &&
+         MPI_SUCCESS != MPI_Irecv(&dest[getVecOffset(b.r_st[0], b.r_st[1], b.r_st[2], num_compo)],
+                                  1,
+                                  t->k_plane,
+                                  b.nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[dir*2]) ) return false;
+
+    if ( MPI_SUCCESS != MPI_Isend(&dest[getVecOffset(b.s_st[0], b.s_st[1], b.s_st[2], num_compo)],
+                                  1,
+                                  t->k_plane,
+                                  b.nID,
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &req[dir*2+1]) ) return false;
+  }
+
+  kf_posted = 1;
+
+  return true;
+}
+
+
+
+// #############################################################
+template
+bool BrickComm::Comm_kface_wait(float* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(double* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(int* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(short* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_kface_wait(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief K面の平面を直接送受信する袖通信の完了待ち
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note K面の送信が未開始であれば、X, Y方向をunpackして開始した後、全ての完了を待つ
+ */
+template <class T>
+bool BrickComm::Comm_kface_wait(T* dest,
+                                const int gc_comm,
+                                const int num_compo,
+                                MPI_Request *req)
+{
+  if ( !dest || !req ) return false;
+
+  if ( !kface_Post(dest, gc_comm, num_compo, req) ) return false;
+
+  if ( MPI_SUCCESS != MPI_Waitall(NOFACE*2, req, MPI_STATUSES_IGNORE) ) return false;
+
+  return true;
+}
@@ -0,0 +1,710 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommN.cpp
+ * @brief  BrickComm class, N-component vector exchange
+ * @note   init()で与えた成分数までの任意の成分数の配列を、隣接ランクごとに
+ *         1つのメッセージで通信する（成分ごとのスカラー通信は不要）
+ *         成分の並びはsetVecLayout()による (既定は_IDX_V3Dと同じく成分が最外)
+ *         COMM_PACKでは全方向を1つの並列領域でpackし、packを終えた方向から
+ *         送信する。受信を完了した方向からunpackする
+ *         comm_modeの振り分けはcomm_Start(), comm_Finish()で行い、
+ *         Comm_S_*, Comm_V_*も成分数1, 3としてここを通る
+ *         maskで一部の方向のみを指定した場合は、comm_modeによらずCOMM_PACKとし、
+ *         maskの方向の袖を受信し、その反対方向へ送信する
+ *         （全ランクで同じmaskとすれば、片側のみのmaskでも送受信が対応する）
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief 全方向の受信を開始し、1つの並列領域でpackしながら送信を開始 (COMM_PACK)
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @retval true-success, false-fail
+ * @note 要求の並びは IsendIrecv() と同じ (面は送信が先、辺・点は受信が先)
+ *       辺・点のバッファは、隣接のある方向だけを詰めて並べる (unpack_Arrivedと同じ)
+ *       送信は、packを終えた方向から開始する (pack_Boxes)
+ *       隣接ランクが自ランクの方向は、送信の開始後に配列内でコピーし、unpack済みとする
+ *       maskの方向から受信し、maskの反対方向へ送信する
+ *       受信しない方向は要求をMPI_REQUEST_NULLのままとし、unpack済みとする
+ */
+template <class T>
+bool BrickComm::box_Start(T* src,
+                          const int gc_comm,
+                          const int num_compo,
+                          MPI_Request *req,
+                          const unsigned mask)
+{
+  MPI_Datatype dtype = GetMPI_Datatype(src);
+  if ( dtype == MPI_DATATYPE_NULL ) return false;
+
+  // Communication identifier
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+  dir_arrived = 0;
+  dir_unpacked = ~mask;
+
+  CommBox box[NOFACE];
+  const CommBox* bp[NOFACE];
+  T* sbuf[NOFACE];
+  int sdir[NOFACE];
+  MPI_Request* sreq[NOFACE];
+  int n = 0;
+
+#ifdef _DIAGONAL_COMM
+  size_t e_ptr = 0;
+  size_t c_ptr = 0;
+#endif
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox* b = &box[dir];
+    setCommBox(dir, gc_comm, b);
+    if ( b->nID < 0 ) continue;
+
+    size_t sz = (size_t)b->len * num_compo;
+    T *sb, *rb;
+    int ir, is;
+
+    if ( dir < 6 ) {
+      char *cs, *cr;
+      if ( !getDirBuf(dir, &cs, &cr) ) return false;
+      sb = (T*)cs;
+      rb = (T*)cr;
+      ir = dir*2+1;
+      is = dir*2;
+    }
+#ifdef _DIAGONAL_COMM
+    else if ( dir <= E_pXpY ) {
+      sb = (T*)f_es + e_ptr;
+      rb = (T*)f_er + e_ptr;
+      e_ptr += sz;
+      ir = dir*2;
+      is = dir*2+1;
+    }
+    else {
+      sb = (T*)f_cs + c_ptr;
+      rb = (T*)f_cr + c_ptr;
+      c_ptr += sz;
+      ir = dir*2;
+      is = dir*2+1;
+    }
+#else
+    else {
+      continue;
+    }
+#endif
+
+    // バッファの位置は、自ランク、maskにない方向も含めてunpack_Arrivedと揃える
+    if ( dir_self & (1u << dir) ) continue;
+
+    if ( (mask & (1u << dir)) &&
+         MPI_SUCCESS != MPI_Irecv(rb,
+                                  (int)sz,
+                                  dtype,
+                                  b->nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[ir]) ) return false;
+
+    if ( !(mask & (1u << getOppositeDir(dir))) ) continue;
+
+    bp[n]   = b;
+    sbuf[n] = sb;
+    sdir[n] = dir;
+    sreq[n] = &req[is];
+    n++;
+  }
+
+  if ( n > 0 && !pack_Boxes(src, num_compo, n, bp, sbuf, sdir, sreq) ) return false;
+
+  if ( dir_self & mask ) {
+    copy_Self(src, num_compo, dir_self & mask, box);
+    dir_unpacked |= dir_self;
+  }
+
+  // 通信スレッドがあれば、waitまで通信を進める
+  progress_Post(src, gc_comm, num_compo, req);
+
+  return true;
+}
+
+
+// #############################################################
+/*
+ * @brief 面ごとにpackし、送受信を開始する従来の経路 (COMM_PACK, 1スレッド)
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1 : pack_S*, 3 : pack_V*)
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note isLegacyPack()の条件でcomm_Start()から呼ぶ
+ *       X, Y, Zの順に面をpackして送受信し、辺・点はpack_?E*, pack_?C*が要求を出す
+ *       要求とバッファの並びはbox_Start()と同じで、waitはunpack_Arrived()による
+ */
+template <class T>
+bool BrickComm::legacy_Start(T* src,
+                             const int gc_comm,
+                             const int num_compo,
+                             MPI_Request *req)
+{
+  const bool node = ( grid_type == "node" );
+  const bool vec  = ( num_compo == 3 );
+
+  T* b_ims = (T*)f_ims;  // I- direction send
+  T* b_imr = (T*)f_imr;  // I- direction recv
+  T* b_ips = (T*)f_ips;  // I+ direction send
+  T* b_ipr = (T*)f_ipr;  // I+ direction recv
+  T* b_jms = (T*)f_jms;  // J- direction send
+  T* b_jmr = (T*)f_jmr;  // J- direction recv
+  T* b_jps = (T*)f_jps;  // J+ direction send
+  T* b_jpr = (T*)f_jpr;  // J+ direction recv
+  T* b_kms = (T*)f_kms;  // K- direction send
+  T* b_kmr = (T*)f_kmr;  // K- direction recv
+  T* b_kps = (T*)f_kps;  // K+ direction send
+  T* b_kpr = (T*)f_kpr;  // K+ direction recv
+#ifdef _DIAGONAL_COMM
+  T* b_es = (T*)f_es;   // edge send
+  T* b_er = (T*)f_er;   // edge recv
+  T* b_cs = (T*)f_cs;   // corner send
+  T* b_cr = (T*)f_cr;   // corner recv
+#endif
+
+
+  // Communication identifier
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+  dir_arrived = 0;
+  dir_unpacked = 0;
+
+  // 実際に送受信するメッセージサイズ
+  int msz[3];
+  msz[0] = size[1] * size[2] * gc_comm * num_compo;
+  msz[1] = size[0] * size[2] * gc_comm * num_compo;
+  msz[2] = size[0] * size[1] * gc_comm * num_compo;
+
+
+  // X direction
+  int nIDm = comm_tbl[I_minus];
+  int nIDp = comm_tbl[I_plus];
+  if ( vec ) {
+    if ( node ) pack_VXnode(src, gc_comm, b_ims, b_ips, nIDm, nIDp);
+    else        pack_VXcell(src, gc_comm, b_ims, b_ips, nIDm, nIDp);
+  }
+  else {
+    if ( node ) pack_SXnode(src, gc_comm, b_ims, b_ips, nIDm, nIDp);
+    else        pack_SXcell(src, gc_comm, b_ims, b_ips, nIDm, nIDp);
+  }
+  if ( !IsendIrecv(b_ims, b_imr, b_ips, b_ipr, msz[0], nIDm, nIDp, I_minus, &req[0]) ) return false;
+
+
+  // Y direction
+  nIDm = comm_tbl[J_minus];
+  nIDp = comm_tbl[J_plus];
+  if ( vec ) {
+    if ( node ) pack_VYnode(src, gc_comm, b_jms, b_jps, nIDm, nIDp);
+    else        pack_VYcell(src, gc_comm, b_jms, b_jps, nIDm, nIDp);
+  }
+  else {
+    if ( node ) pack_SYnode(src, gc_comm, b_jms, b_jps, nIDm, nIDp);
+    else        pack_SYcell(src, gc_comm, b_jms, b_jps, nIDm, nIDp);
+  }
+  if ( !IsendIrecv(b_jms, b_jmr, b_jps, b_jpr, msz[1], nIDm, nIDp, J_minus, &req[4]) ) return false;
+
+
+  // Z direction
+  nIDm = comm_tbl[K_minus];
+  nIDp = comm_tbl[K_plus];
+  if ( vec ) {
+    if ( node ) pack_VZnode(src, gc_comm, b_kms, b_kps, nIDm, nIDp);
+    else        pack_VZcell(src, gc_comm, b_kms, b_kps, nIDm, nIDp);
+  }
+  else {
+    if ( node ) pack_SZnode(src, gc_comm, b_kms, b_kps, nIDm, nIDp);
+    else        pack_SZcell(src, gc_comm, b_kms, b_kps, nIDm, nIDp);
+  }
+  if ( !IsendIrecv(b_kms, b_kmr, b_kps, b_kpr, msz[2], nIDm, nIDp, K_minus, &req[8]) ) return false;
+
+
+#ifdef _DIAGONAL_COMM
+  // edge, corner
+  if ( vec ) {
+    if ( node ) {
+      if ( !pack_VEnode(src, gc_comm, b_es, b_er, req) ) return false;
+      if ( !pack_VCnode(src, gc_comm, b_cs, b_cr, req) ) return false;
+    }
+    else {
+      if ( !pack_VEcell(src, gc_comm, b_es, b_er, req) ) return false;
+      if ( !pack_VCcell(src, gc_comm, b_cs, b_cr, req) ) return false;
+    }
+  }
+  else {
+    if ( node ) {
+      if ( !pack_SEnode(src, gc_comm, b_es, b_er, req) ) return false;
+      if ( !pack_SCnode(src, gc_comm, b_cs, b_cr, req) ) return false;
+    }
+    else {
+      if ( !pack_SEcell(src, gc_comm, b_es, b_er, req) ) return false;
+      if ( !pack_SCcell(src, gc_comm, b_cs, b_cr, req) ) return false;
+    }
+  }
+#endif
+
+  // 通信スレッドがあれば、waitまで通信を進める
+  progress_Post(src, gc_comm, num_compo, req);
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::comm_Start(float* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(double* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(int* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(long long* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(short* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Start(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+
+/* #########################################################
+ * @brief comm_modeに応じた袖通信の開始
+ * @param [in,out]  src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (init()で与えた成分数以下)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      prec      転送精度 (PRECmode)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @retval true-success, false-fail
+ * @note Comm_S_*, Comm_V_*, Comm_N_*の共通の入口。方式の追加はここで振り分ける
+ */
+template <class T>
+bool BrickComm::comm_Start(T* src,
+                           const int gc_comm,
+                           const int num_compo,
+                           MPI_Request *req,
+                           const int prec,
+                           const unsigned mask)
+{
+  if ( !src || !req || buf_flag != 1 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+
+  if ( !isBufCompo(src, num_compo) ) {
+    printf("Error : num_compo [%d] must be in [1, %d]\n", num_compo, (int)(sizeof(double) * buf_compo / sizeof(T)));
+    return false;
+  }
+
+  // 方向ごとの状態、送受信バッファはインスタンスで共有するので、同時に1つとする
+  if ( comm_active ) {
+    printf("Error : another halo exchange is in progress (call the wait first)\n");
+    return false;
+  }
+
+  bool ret;
+
+  // 精度を落とした転送
+  if ( prec != PREC_FULL ) ret = Comm_reduced(src, gc_comm, num_compo, prec, req, mask);
+  // 一部の方向のみの通信
+  else if ( !isAllDir(mask) ) ret = box_Start(src, gc_comm, num_compo, req, mask);
+  // 派生データ型による直接送受信
+  else if ( comm_mode == COMM_DTYPE ) ret = Comm_dtype(src, gc_comm, num_compo, req);
+  // K面の平面を直接送受信
+  else if ( comm_mode == COMM_KFACE ) ret = Comm_kface(src, gc_comm, num_compo, req);
+  // 近傍集団通信
+  else if ( comm_mode == COMM_NEIGHBOR ) ret = Comm_neighbor(src, gc_comm, num_compo, req);
+  // 片側通信
+  else if ( comm_mode == COMM_RMA ) ret = Comm_rma(src, gc_comm, num_compo, req);
+  // 同じノードは共有メモリ
+  else if ( comm_mode == COMM_SHM ) ret = Comm_shm(src, gc_comm, num_compo, req);
+  // 可逆圧縮
+  else if ( comm_mode == COMM_ZIP ) ret = Comm_zip(src, gc_comm, num_compo, req);
+  // X, Y, Zの順の面の通信で辺・点も埋める (cellのみ、nodeはエラー)
+  else if ( comm_mode == COMM_SWEEP ) ret = Comm_sweep(src, gc_comm, num_compo, req);
+  // 1スレッドのスカラー・ベクトルは、従来の面ごとのpack
+  else if ( isLegacyPack(num_compo) ) ret = legacy_Start(src, gc_comm, num_compo, req);
+  else ret = box_Start(src, gc_comm, num_compo, req, mask);
+
+  if ( ret ) comm_active = 1;
+
+  return ret;
+}
+
+
+// #############################################################
+template
+bool BrickComm::comm_Finish(float* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(double* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(int* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(short* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::comm_Finish(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+
+/* #########################################################
+ * @brief comm_modeに応じた袖通信の完了待ち
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      prec      転送精度 (PRECmode)、開始と同じ値
+ * @param [in]      mask      袖を受信する方向 (DIRmask)、開始と同じ値
+ * @retval true-success, false-fail
+ */
+template <class T>
+bool BrickComm::comm_Finish(T* dest,
+                            const int gc_comm,
+                            const int num_compo,
+                            MPI_Request *req,
+                            const int prec,
+                            const unsigned mask)
+{
+  // 通信スレッドから通信を取り戻す
+  progress_Cancel();
+
+  if ( !dest || !req ) return false;
+
+  // 成否によらず、次の通信を開始できる
+  comm_active = 0;
+
+  // 精度を落とした転送
+  if ( prec != PREC_FULL ) return Comm_reduced_wait(dest, gc_comm, num_compo, prec, req, mask);
+
+  // 一部の方向のみの通信
+  if ( !isAllDir(mask) ) return unpack_Arrived(dest, gc_comm, num_compo, req, true);
+
+  // 派生データ型による直接送受信
+  if ( comm_mode == COMM_DTYPE ) return Comm_dtype_wait(req);
+
+  // K面の平面を直接送受信
+  if ( comm_mode == COMM_KFACE ) return Comm_kface_wait(dest, gc_comm, num_compo, req);
+
+  // 近傍集団通信
+  if ( comm_mode == COMM_NEIGHBOR ) return Comm_neighbor_wait(dest, gc_comm, num_compo, req);
+
+  // 片側通信
+  if ( comm_mode == COMM_RMA ) return Comm_rma_wait(dest, gc_comm, num_compo, req);
+
+  // 同じノードは共有メモリ
+  if ( comm_mode == COMM_SHM ) return Comm_shm_wait(dest, gc_comm, num_compo, req);
+
+  // 可逆圧縮
+  if ( comm_mode == COMM_ZIP ) return Comm_zip_wait(dest, gc_comm, num_compo, req);
+
+  // X, Y, Zの順の面の通信で辺・点も埋める (cellのみ)
+  if ( comm_mode == COMM_SWEEP ) return Comm_sweep_wait(dest, gc_comm, num_compo, req);
+
+  // 受信を完了した方向から順にunpack
+  return unpack_Arrived(dest, gc_comm, num_compo, req, true);
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_N_node(float* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(double* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(int* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(long long* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(short* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_node(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+
+/* #########################################################
+ * @brief N成分の変数のノンブロッキング通信 node
+ * @param [in,out]  src       N成分の変数
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (init()で与えた成分数以下)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      prec      転送精度 (PRECmode)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @retval true-success, false-fail
+ */
+template <class T>
+bool BrickComm::Comm_N_node(T* src,
+                            const int gc_comm,
+                            const int num_compo,
+                            MPI_Request *req,
+                            const int prec,
+                            const unsigned mask)
+{
+  if ( !isGridType("node") ) return false;
+  return comm_Start(src, gc_comm, num_compo, req, prec, mask);
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_N_cell(float* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(double* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(int* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(long long* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(short* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_cell(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+
+/* #########################################################
+ * @brief N成分の変数のノンブロッキング通信 cell
+ * @param [in,out]  src       N成分の変数
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (init()で与えた成分数以下)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      prec      転送精度 (PRECmode)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @retval true-success, false-fail
+ */
+template <class T>
+bool BrickComm::Comm_N_cell(T* src,
+                            const int gc_comm,
+                            const int num_compo,
+                            MPI_Request *req,
+                            const int prec,
+                            const unsigned mask)
+{
+  if ( !isGridType("cell") ) return false;
+  return comm_Start(src, gc_comm, num_compo, req, prec, mask);
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_N_wait_node(float* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(double* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(int* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(short* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_node(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+
+/* #########################################################
+ * @brief N成分の変数の通信の完了待ち node
+ * @param [in,out]  dest      N成分の変数
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (init()で与えた成分数以下)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      prec      転送精度 (PRECmode)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @retval true-success, false-fail
+ */
+template <class T>
+bool BrickComm::Comm_N_wait_node(T* dest,
+                                 const int gc_comm,
+                                 const int num_compo,
+                                 MPI_Request *req,
+                                 const int prec,
+                                 const unsigned mask)
+{
+  if ( !isGridType("node") ) return false;
+  return comm_Finish(dest, gc_comm, num_compo, req, prec, mask);
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_N_wait_cell(float* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(double* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(int* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(short* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::Comm_N_wait_cell(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+
+/* #########################################################
+ * @brief N成分の変数の通信の完了待ち cell
+ * @param [in,out]  dest      N成分の変数
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (init()で与えた成分数以下)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      prec      転送精度 (PRECmode)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @retval true-success, false-fail
+ */
+template <class T>
+bool BrickComm::Comm_N_wait_cell(T* dest,
+                                 const int gc_comm,
+                                 const int num_compo,
+                                 MPI_Request *req,
+                                 const int prec,
+                                 const unsigned mask)
+{
+  if ( !isGridType("cell") ) return false;
+  return comm_Finish(dest, gc_comm, num_compo, req, prec, mask);
+}
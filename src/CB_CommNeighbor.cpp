@@ -0,0 +1,237 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommNeighbor.cpp
+ * @brief  BrickComm class, halo exchange with MPI-3 neighborhood collective
+ * @note   comm_tblの隣接をMPI_Dist_graph_create_adjacentのグラフとし、
+ *         全方向の送受信をMPI_Ineighbor_alltoallwの1回で行う
+ *         バッファは方向ごとに別の領域なので、MPI_BOTTOMからの絶対アドレスで指定する
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief comm_tblから近傍集団通信のトポロジーを作成
+ * @retval true-success, false-fail
+ * @note 送信先は方向の順、受信元は送信側の方向（受信方向の反対）の順に並べる
+ *       同じランクが複数の方向の隣接となる場合（周期境界で分割数2など）も、
+ *       同じ隣接との送受信は辺の順に対応するので、方向が一致する
+ */
+bool BrickComm::setNeighborComm()
+{
+  if ( nbr_comm != MPI_COMM_NULL ) return true;
+
+  int src[NOFACE], dst[NOFACE];
+  int ns = 0;
+  int nr = 0;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    if ( comm_tbl[dir] >= 0 ) {
+      nbr_sdir[ns] = dir;
+      dst[ns++] = comm_tbl[dir];
+    }
+
+    // 送信側の方向がdirとなる受信
+    int rdir = getOppositeDir(dir);
+    if ( comm_tbl[rdir] >= 0 ) {
+      nbr_rdir[nr] = rdir;
+      src[nr++] = comm_tbl[rdir];
+    }
+  }
+
+  nbr_num = ns;
+
+  if ( MPI_SUCCESS != MPI_Dist_graph_create_adjacent(mpi_comm,
+                                                     nr, src, MPI_UNWEIGHTED,
+                                                     ns, dst, MPI_UNWEIGHTED,
+                                                     MPI_INFO_NULL,
+                                                     0,
+                                                     &nbr_comm) ) return false;
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_neighbor(float* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(double* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(int* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(long long* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(short* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief 近傍集団通信による袖通信の開始
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [out]     req       Array of MPI request (NOFACE*2)、req[0]のみ使用
+ * @retval true-success, false-fail
+ * @note 集団通信にタグはないので、同じ通信クラスで複数の通信を同時に行う場合は、
+ *       全ランクで開始の順を揃える
+ */
+template <class T>
+bool BrickComm::Comm_neighbor(T* src,
+                              const int gc_comm,
+                              const int num_compo,
+                              MPI_Request *req)
+{
+  if ( !src || !req || buf_flag != 1 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( !isBufCompo(src, num_compo) ) return false;
+
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+
+  if ( !setNeighborComm() ) return false;
+
+  MPI_Datatype dtype = GetMPI_Datatype(src);
+
+  int s_cnt[NOFACE], r_cnt[NOFACE];
+  MPI_Aint s_dsp[NOFACE], r_dsp[NOFACE];
+  MPI_Datatype s_type[NOFACE], r_type[NOFACE];
+
+  for (int n=0; n<nbr_num; n++) {
+    CommBox b;
+    char *cs, *cr;
+
+    // send
+    int dir = nbr_sdir[n];
+    setCommBox(dir, gc_comm, &b);
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    pack_Box(src, num_compo, &b, (T*)cs);
+
+    s_cnt[n] = b.len * num_compo;
+    s_type[n] = dtype;
+    MPI_Get_address(cs, &s_dsp[n]);
+
+    // recv
+    dir = nbr_rdir[n];
+    setCommBox(dir, gc_comm, &b);
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    r_cnt[n] = b.len * num_compo;
+    r_type[n] = dtype;
+    MPI_Get_address(cr, &r_dsp[n]);
+  }
+
+  if ( MPI_SUCCESS != MPI_Ineighbor_alltoallw(MPI_BOTTOM, s_cnt, s_dsp, s_type,
+                                              MPI_BOTTOM, r_cnt, r_dsp, r_type,
+                                              nbr_comm,
+                                              &req[0]) ) return false;
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_neighbor_wait(float* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(double* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(int* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(short* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_neighbor_wait(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief 近傍集団通信による袖通信の完了待ち
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note 受信領域の重なるnodeでも従来と同じ結果となるよう、方向の順にunpackする
+ */
+template <class T>
+bool BrickComm::Comm_neighbor_wait(T* dest,
+                                   const int gc_comm,
+                                   const int num_compo,
+                                   MPI_Request *req)
+{
+  if ( !dest || !req ) return false;
+
+  if ( MPI_SUCCESS != MPI_Wait(&req[0], MPI_STATUS_IGNORE) ) return false;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    unpack_Box(dest, num_compo, &b, (T*)cr);
+  }
+
+  return true;
+}
@@ -0,0 +1,382 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommOverlap.cpp
+ * @brief  BrickComm class, halo exchange overlapped with computation
+ * @note   通信を開始した後、袖に依存しない内部領域を計算し、受信を完了した
+ *         方向から順にunpackして、依存する袖が揃った境界領域を計算する
+ *
+ *   CommOverlap ov;
+ *   CM.Comm_overlap(&ov, q, gc);
+ *   kernel(ov.ist, ov.ied);
+ *   int f;
+ *   while ( CM.Comm_overlap_next(&ov, q, &f) && f >= 0 ) kernel(ov.b_st[f], ov.b_ed[f]);
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief 内部領域と面ごとの境界領域、その依存方向を設定
+ * @param [in,out]  ov   オーバーラップ領域（gc, boxを設定済み）
+ * @note 内部領域は、gc広げても受信領域と交わらない範囲とする
+ *       境界領域はX面、Y面、Z面の順に、先の面の板を除いて重複なく分割する
+ *       境界領域をgc広げた範囲と交わる受信領域の方向を依存方向とする
+ */
+void BrickComm::setOverlapRegion(CommOverlap* ov)
+{
+  int gc = ov->gc;
+  int lo[3], hi[3];
+
+  for (int m=0; m<3; m++) {
+    lo[m] = 0;
+    hi[m] = size[m];
+  }
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    const CommBox* b = &ov->box[dir];
+    if ( b->nID < 0 ) continue;
+
+    int o[3];
+    getDirOffset(dir, o);
+
+    for (int m=0; m<3; m++) {
+      if ( o[m] < 0 && lo[m] < b->r_ed[m] + gc ) lo[m] = b->r_ed[m] + gc;
+      if ( o[m] > 0 && hi[m] > b->r_st[m] - gc ) hi[m] = b->r_st[m] - gc;
+    }
+  }
+
+  // 領域が小さく内部領域がない場合
+  for (int m=0; m<3; m++) {
+    if ( lo[m] > size[m] ) lo[m] = size[m];
+    if ( hi[m] < lo[m] )   hi[m] = lo[m];
+    ov->ist[m] = lo[m];
+    ov->ied[m] = hi[m];
+  }
+
+  // 面ごとの板 X面は全体、Y面はXの内側、Z面はX, Yの内側
+  for (int f=0; f<6; f++) {
+    int m = f / 2;
+
+    for (int n=0; n<3; n++) {
+      if ( n < m ) {
+        ov->b_st[f][n] = lo[n];
+        ov->b_ed[f][n] = hi[n];
+      }
+      else {
+        ov->b_st[f][n] = 0;
+        ov->b_ed[f][n] = size[n];
+      }
+    }
+
+    if ( f % 2 == 0 ) {
+      ov->b_ed[f][m] = lo[m];
+    }
+    else {
+      ov->b_st[f][m] = hi[m];
+    }
+
+    ov->dep[f] = 0;
+    ov->done[f] = 0;
+
+    bool empty = false;
+    for (int n=0; n<3; n++) {
+      if ( ov->b_st[f][n] >= ov->b_ed[f][n] ) empty = true;
+    }
+
+    // 空の板は返さない
+    if ( empty ) {
+      ov->done[f] = 1;
+      continue;
+    }
+
+    for (int dir=0; dir<NOFACE; dir++) {
+      const CommBox* b = &ov->box[dir];
+      if ( b->nID < 0 ) continue;
+
+      bool hit = true;
+      for (int n=0; n<3; n++) {
+        if ( ov->b_st[f][n] - gc >= b->r_ed[n] ||
+             ov->b_ed[f][n] + gc <= b->r_st[n] ) hit = false;
+      }
+      if ( hit ) ov->dep[f] |= (1u << dir);
+    }
+  }
+
+  ov->arrived = 0;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, float* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, double* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, int* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, unsigned* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, long long* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, signed char* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, unsigned char* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, short* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, CB_half* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, CB_bf16* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, std::complex<float>* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::Comm_overlap(CommOverlap* ov, std::complex<double>* src, const int gc_comm, const int num_compo);
+
+
+/* #########################################################
+ * @brief 計算とオーバーラップする袖通信の開始
+ * @param [out]     ov        オーバーラップ領域
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数（ステンシルの幅）
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @retval true-success, false-fail
+ * @note 受信は送信側の方向をタグとする
+ *       通信方式(COMMmode)によらずpack/unpackで送受信する
+ */
+template <class T>
+bool BrickComm::Comm_overlap(CommOverlap* ov,
+                             T* src,
+                             const int gc_comm,
+                             const int num_compo)
+{
+  if ( !ov || !src || buf_flag != 1 ) return false;
+  if ( ov->in_flight ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( !isBufCompo(src, num_compo) ) return false;
+
+  // 送受信バッファはComm_S_*, Comm_V_*などと共有する
+  if ( comm_active ) {
+    printf("Error : another halo exchange is in progress (call the wait first)\n");
+    return false;
+  }
+
+  MPI_Datatype dtype = GetMPI_Datatype(src);
+
+  ov->gc = gc_comm;
+  ov->num_compo = num_compo;
+
+  for (int dir=0; dir<NOFACE; dir++) setCommBox(dir, gc_comm, &ov->box[dir]);
+  for (int i=0; i<NOFACE*2; i++) ov->req[i] = MPI_REQUEST_NULL;
+
+  setOverlapRegion(ov);
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox* b = &ov->box[dir];
+    if ( b->nID < 0 ) continue;
+
+    int sz = b->len * num_compo;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+    T* sb = (T*)cs;
+    T* rb = (T*)cr;
+
+    if ( MPI_SUCCESS != MPI_Irecv(rb,
+                                  sz,
+                                  dtype,
+                                  b->nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &ov->req[dir]) ) return false;
+
+    pack_Box(src, num_compo, b, sb);
+
+    if ( MPI_SUCCESS != MPI_Isend(sb,
+                                  sz,
+                                  dtype,
+                                  b->nID,
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &ov->req[NOFACE+dir]) ) return false;
+  }
+
+  ov->in_flight = 1;
+  comm_active = 1;
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, float* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, double* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, int* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, unsigned* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, long long* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, signed char* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, unsigned char* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, short* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, CB_half* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, CB_bf16* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, std::complex<float>* dest, int* face);
+
+template
+bool BrickComm::Comm_overlap_next(CommOverlap* ov, std::complex<double>* dest, int* face);
+
+
+/* #########################################################
+ * @brief 計算可能になった境界領域を返す
+ * @param [in,out]  ov    オーバーラップ領域
+ * @param [in,out]  dest  受信する配列
+ * @param [out]     face  境界領域の面番号 (0-5)、全て返した後は-1
+ * @retval true-success, false-fail
+ * @note 全ての境界領域を返した後は、残りの受信をunpackし、送信の完了を待つ
+ */
+template <class T>
+bool BrickComm::Comm_overlap_next(CommOverlap* ov,
+                                  T* dest,
+                                  int* face)
+{
+  if ( !ov || !dest || !face ) return false;
+
+  *face = -1;
+  if ( !ov->in_flight ) return true;
+
+  while (true) {
+    bool remain = false;
+
+    for (int f=0; f<6; f++) {
+      if ( ov->done[f] ) continue;
+      remain = true;
+
+      if ( (ov->dep[f] & ~ov->arrived) == 0 ) {
+        ov->done[f] = 1;
+        *face = f;
+        return true;
+      }
+    }
+
+    // 受信を1つ完了してunpack
+    int dir = MPI_UNDEFINED;
+    if ( MPI_SUCCESS != MPI_Waitany(NOFACE, ov->req, &dir, MPI_STATUS_IGNORE) ) return false;
+
+    if ( dir == MPI_UNDEFINED ) {
+      if ( remain ) return false;
+      break;
+    }
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+    unpack_Box(dest, ov->num_compo, &ov->box[dir], (T*)cr);
+
+    ov->arrived |= (1u << dir);
+  }
+
+  comm_active = 0;
+
+  if ( MPI_SUCCESS != MPI_Waitall(NOFACE, &ov->req[NOFACE], MPI_STATUSES_IGNORE) ) return false;
+
+  ov->in_flight = 0;
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, float* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, double* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, int* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, unsigned* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, long long* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, signed char* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, unsigned char* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, short* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, CB_half* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, CB_bf16* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, std::complex<float>* dest);
+
+template
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, std::complex<double>* dest);
+
+
+/* #########################################################
+ * @brief 計算とオーバーラップする袖通信の完了待ち
+ * @param [in,out]  ov    オーバーラップ領域
+ * @param [in,out]  dest  受信する配列
+ * @retval true-success, false-fail
+ */
+template <class T>
+bool BrickComm::Comm_overlap_wait(CommOverlap* ov, T* dest)
+{
+  int f = 0;
+
+  while ( ov && ov->in_flight ) {
+    if ( !Comm_overlap_next(ov, dest, &f) ) return false;
+  }
+
+  return ( ov != NULL );
+}
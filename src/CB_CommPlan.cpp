@@ -0,0 +1,560 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommPlan.cpp
+ * @brief  BrickComm class, persistent communication plan
+ */
+
+#include "CB_Comm.h"
+
+
+// 各方向の隣接ブロックへのオフセット (DIRectionの並び)
+static const int dir_offset[26][3] = {
+  {-1, 0, 0}, { 1, 0, 0}, { 0,-1, 0}, { 0, 1, 0}, { 0, 0,-1}, { 0, 0, 1},
+  // edge
+  { 0,-1,-1}, { 0, 1,-1}, { 0,-1, 1}, { 0, 1, 1},
+  {-1, 0,-1}, { 1, 0,-1}, {-1, 0, 1}, { 1, 0, 1},
+  {-1,-1, 0}, { 1,-1, 0}, {-1, 1, 0}, { 1, 1, 0},
+  // corner
+  {-1,-1,-1}, { 1,-1,-1}, {-1, 1,-1}, { 1, 1,-1},
+  {-1,-1, 1}, { 1,-1, 1}, {-1, 1, 1}, { 1, 1, 1}
+};
+
+
+// #############################################################
+// 隣接方向のオフセットを返す
+void BrickComm::getDirOffset(const int dir, int* o)
+{
+  o[0] = dir_offset[dir][0];
+  o[1] = dir_offset[dir][1];
+  o[2] = dir_offset[dir][2];
+}
+
+
+// #############################################################
+// 反対方向を返す
+int BrickComm::getOppositeDir(const int dir)
+{
+  for (int d=0; d<NOFACE; d++) {
+    if ( dir_offset[d][0] == -dir_offset[dir][0] &&
+         dir_offset[d][1] == -dir_offset[dir][1] &&
+         dir_offset[d][2] == -dir_offset[dir][2] ) return d;
+  }
+  return -1;
+}
+
+
+// #############################################################
+// 方向dirへの送信のタグを返す
+int BrickComm::getTag(const int dir) const
+{
+  return comm_tag * NOFACE + dir;
+}
+
+
+// #############################################################
+/*
+ * @brief 方向dirの送受信領域を作成
+ * @param [in]  dir  方向 (DIRection)
+ * @param [in]  gc   通信する袖の層数
+ * @param [out] b    送受信領域
+ * @note 領域は次のとおり
+ *  cell       : 送信 [0, gc), [N-gc, N)   受信 [-gc, 0), [N, N+gc)
+ *  node       : 送信 [1, 1+gc), [N-gc, N)  受信 [1-gc, 1), [N, N+gc)
+ *               ただし gc=1 の面は [N-2, N-1) を送信し、[-1, 0) で受信する
+ *               （共有する格子点0ではなく、袖の1層を受け取る）
+ *               オフセット0の軸は、cellと面は[0, N)、nodeの辺・点は[1, N)
+ */
+void BrickComm::setCommBox(const int dir, const int gc, CommBox* b)
+{
+  int o[3];
+  getDirOffset(dir, o);
+
+  bool node = (grid_type == "node");
+  bool face = (dir < 6);
+
+  b->nID = comm_tbl[dir];
+  b->len = 1;
+
+  for (int m=0; m<3; m++) {
+    int N = size[m];
+
+    if ( o[m] == 0 ) {
+      int st = (node && !face) ? 1 : 0;
+      b->s_st[m] = b->r_st[m] = st;
+      b->s_ed[m] = b->r_ed[m] = N;
+    }
+    else if ( o[m] < 0 ) {
+      if ( !node ) {
+        b->s_st[m] = 0;
+        b->r_st[m] = -gc;
+      }
+      else {
+        b->s_st[m] = 1;
+        b->r_st[m] = (face && gc == 1) ? -1 : 1-gc;
+      }
+      b->s_ed[m] = b->s_st[m] + gc;
+      b->r_ed[m] = b->r_st[m] + gc;
+    }
+    else {
+      b->s_st[m] = (node && face && gc == 1) ? N-2 : N-gc;
+      b->r_st[m] = N;
+      b->s_ed[m] = b->s_st[m] + gc;
+      b->r_ed[m] = N + gc;
+    }
+
+    b->len *= b->s_ed[m] - b->s_st[m];
+  }
+}
+
+
+// #############################################################
+/*
+ * @brief K面の送受信領域を袖を含む平面で作成
+ * @param [in]  dir  方向 (K_minus, K_plus)
+ * @param [in]  gc   通信する袖の層数
+ * @param [out] b    送受信領域
+ * @note k方向はsetCommBox()と同じ範囲、i, j方向は袖を含む[-VC, N+VC)とする
+ *       平面はメモリ上で連続になる
+ */
+void BrickComm::setCommBox_K(const int dir, const int gc, CommBox* b)
+{
+  setCommBox(dir, gc, b);
+
+  int VC = halo_width;
+
+  for (int m=0; m<2; m++) {
+    b->s_st[m] = b->r_st[m] = -VC;
+    b->s_ed[m] = b->r_ed[m] = size[m] + VC;
+  }
+
+  b->len = (size[0]+2*VC) * (size[1]+2*VC) * gc;
+}
+
+
+// K面を平面で直接送受信する方向
+static inline bool isKplane(const CommPlan* pl, const int dir)
+{
+  return ( pl->mode == COMM_KFACE && (dir == K_minus || dir == K_plus) );
+}
+
+
+// #############################################################
+template
+bool BrickComm::setCommPlan(CommPlan* pl, float* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, double* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, int* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, unsigned* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, long long* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, signed char* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, unsigned char* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, short* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, CB_half* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, CB_bf16* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, std::complex<float>* src, const int gc_comm, const int num_compo);
+
+template
+bool BrickComm::setCommPlan(CommPlan* pl, std::complex<double>* src, const int gc_comm, const int num_compo);
+
+
+/* #########################################################
+ * @brief 袖通信プランの作成
+ * @param [out]     pl        通信プラン
+ * @param [in]      src       通信する配列（型と形状の確認に利用）
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @retval true-success, false-fail
+ * @note 隣接情報、メッセージサイズ、バッファを確保し、
+ *       MPI_Send_init/MPI_Recv_initで永続リクエストを作成する
+ *       COMM_DTYPEの場合はバッファを確保せず、派生データ型でsrcから直接送受信する
+ *       COMM_KFACEの場合、K面は袖を含む平面をsrcから直接送受信し、
+ *       K方向の辺・点はK面に含まれるので通信しない
+ *       COMM_SWEEPはエラーとする
+ *       成分の並びは作成時のvec_layoutとし、変えた場合は通信しない
+ *       隣接ランクが自ランクの方向は、バッファとリクエストを作らず配列内でコピーする
+ *       （COMM_DTYPE, COMM_KFACEのK面を除く）
+ */
+template <class T>
+bool BrickComm::setCommPlan(CommPlan* pl,
+                            T* src,
+                            const int gc_comm,
+                            const int num_compo)
+{
+  if ( !pl || !src ) return false;
+  if ( pl->sbuf || pl->rbuf || pl->base ) return false; // 作成済み
+  if ( size[0]==0 || size[1]==0 || size[2]==0 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width || num_compo < 1 ) return false;
+
+  MPI_Datatype dtype = GetMPI_Datatype(src);
+  if ( dtype == MPI_DATATYPE_NULL ) return false;
+
+  if ( comm_mode == COMM_SWEEP ) {
+    printf("Error : COMM_SWEEP is not supported by setCommPlan()\n");
+    return false;
+  }
+
+  pl->gc        = gc_comm;
+  pl->num_compo = num_compo;
+  pl->layout    = vec_layout;
+  pl->mode      = ( comm_mode == COMM_NEIGHBOR || comm_mode == COMM_RMA ||
+                    comm_mode == COMM_SHM      || comm_mode == COMM_ZIP )
+                  ? COMM_PACK : comm_mode; // neighbor, rma, shm, zipはプラン非対応
+  pl->esz       = sizeof(T);
+  pl->dtype     = dtype;
+
+  // 隣接情報とバッファ上の位置
+  size_t len = 0;
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox* b = &pl->box[dir];
+    setCommBox(dir, gc_comm, b);
+    pl->ofs[dir] = len;
+
+    if ( pl->mode == COMM_KFACE ) {
+      int o[3];
+      getDirOffset(dir, o);
+      if ( isKplane(pl, dir) ) {
+        setCommBox_K(dir, gc_comm, b);
+        continue;
+      }
+      if ( o[2] != 0 ) b->nID = -1;
+    }
+
+    if ( pl->mode != COMM_DTYPE && (dir_self & (1u << dir)) ) {
+      pl->self |= (1u << dir);
+      continue;
+    }
+
+    if ( b->nID >= 0 ) len += (size_t)b->len * num_compo;
+  }
+
+  if ( pl->mode == COMM_DTYPE ) return setCommPlan_dtype(pl, src);
+
+  if ( len == 0 ) {
+    // 隣接ランクなし
+    if ( pl->mode == COMM_KFACE ) return setCommPlan_kface(pl, src);
+    return true;
+  }
+
+  if ( !(pl->sbuf = new char [len*sizeof(T)]) ) return false;
+  if ( !(pl->rbuf = new char [len*sizeof(T)]) ) return false;
+
+  T* sb = (T*)pl->sbuf;
+  T* rb = (T*)pl->rbuf;
+
+  // 永続リクエスト  受信は送信側の方向をタグとする
+  int n = 0;
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox* b = &pl->box[dir];
+    if ( b->nID < 0 || isKplane(pl, dir) || (pl->self & (1u << dir)) ) continue;
+
+    int sz = b->len * num_compo;
+
+    if ( MPI_SUCCESS != MPI_Recv_init(&rb[pl->ofs[dir]],
+                                      sz,
+                                      dtype,
+                                      b->nID,
+                                      getTag(getOppositeDir(dir)),
+                                      mpi_comm,
+                                      &pl->req[n++]) ) return false;
+
+    if ( MPI_SUCCESS != MPI_Send_init(&sb[pl->ofs[dir]],
+                                      sz,
+                                      dtype,
+                                      b->nID,
+                                      getTag(dir),
+                                      mpi_comm,
+                                      &pl->req[n++]) ) return false;
+  }
+  pl->nreq = n;
+
+  if ( pl->mode == COMM_KFACE ) return setCommPlan_kface(pl, src);
+
+  return true;
+}
+
+
+/* #########################################################
+ * @brief 派生データ型による永続リクエストの作成
+ * @param [in,out]  pl   通信プラン
+ * @param [in]      src  通信する配列
+ * @retval true-success, false-fail
+ * @note リクエストはsrcに束縛されるので、Comm_plan()にはsrcを渡す
+ */
+template <class T>
+bool BrickComm::setCommPlan_dtype(CommPlan* pl, T* src)
+{
+  CommDtype* t = getCommType(pl->dtype, pl->gc, pl->num_compo);
+  if ( !t ) return false;
+
+  pl->base = (void*)src;
+
+  int n = 0;
+  for (int dir=0; dir<NOFACE; dir++) {
+    int nID = pl->box[dir].nID;
+    if ( nID < 0 ) continue;
+
+    if ( t->r_type[dir] != MPI_DATATYPE_NULL &&
+         MPI_SUCCESS != MPI_Recv_init(src,
+                                      1,
+                                      t->r_type[dir],
+                                      nID,
+                                      getTag(getOppositeDir(dir)),
+                                      mpi_comm,
+                                      &pl->req[n++]) ) return false;
+
+    if ( t->s_type[dir] != MPI_DATATYPE_NULL &&
+         MPI_SUCCESS != MPI_Send_init(src,
+                                      1,
+                                      t->s_type[dir],
+                                      nID,
+                                      getTag(dir),
+                                      mpi_comm,
+                                      &pl->req[n++]) ) return false;
+  }
+  pl->nreq = n;
+
+  return true;
+}
+
+
+/* #########################################################
+ * @brief K面の平面による永続リクエストの作成
+ * @param [in,out]  pl   通信プラン
+ * @param [in]      src  通信する配列
+ * @retval true-success, false-fail
+ * @note リクエストはreq[nreq]以降に置き、srcに束縛される
+ */
+template <class T>
+bool BrickComm::setCommPlan_kface(CommPlan* pl, T* src)
+{
+  CommDtype* t = getCommType(pl->dtype, pl->gc, pl->num_compo);
+  if ( !t ) return false;
+
+  pl->base = (void*)src;
+
+  int n = pl->nreq;
+  for (int dir=K_minus; dir<=K_plus; dir++) {
+    CommBox* b = &pl->box[dir];
+    if ( b->nID < 0 ) continue;
+
+    if ( MPI_SUCCESS != MPI_Recv_init(&src[getVecOffset(b->r_st[0], b->r_st[1], b->r_st[2], pl->num_compo)],
+                                      1,
+                                      t->k_plane,
+                                      b->nID,
+                                      getTag(getOppositeDir(dir)),
+                                      mpi_comm,
+                                      &pl->req[n++]) ) return false;
+
+    if ( MPI_SUCCESS != MPI_Send_init(&src[getVecOffset(b->s_st[0], b->s_st[1], b->s_st[2], pl->num_compo)],
+                                      1,
+                                      t->k_plane,
+                                      b->nID,
+                                      getTag(dir),
+                                      mpi_comm,
+                                      &pl->req[n++]) ) return false;
+  }
+  pl->nreq_k = n - pl->nreq;
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_plan(CommPlan* pl, float* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, double* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, int* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, unsigned* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, long long* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, signed char* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, unsigned char* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, short* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, CB_half* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, CB_bf16* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, std::complex<float>* src);
+
+template
+bool BrickComm::Comm_plan(CommPlan* pl, std::complex<double>* src);
+
+
+/* #########################################################
+ * @brief 通信プランによる袖通信の開始
+ * @param [in,out]  pl   通信プラン
+ * @param [in]      src  送信する配列
+ * @retval true-success, false-fail
+ */
+template <class T>
+bool BrickComm::Comm_plan(CommPlan* pl, T* src)
+{
+  if ( !pl || !src ) return false;
+  if ( pl->esz != sizeof(T) || pl->in_flight ) return false;
+
+  // 作成後に成分の並びを変えた場合
+  if ( pl->num_compo > 1 && pl->layout != vec_layout ) return false;
+
+  if ( pl->nreq + pl->nreq_k == 0 && !pl->self ) return true;
+  if ( pl->base && pl->base != (void*)src ) return false;
+
+  if ( pl->mode != COMM_DTYPE ) {
+    T* sb = (T*)pl->sbuf;
+    const CommBox* bp[NOFACE];
+    T* sp[NOFACE];
+    int n = 0;
+
+    for (int dir=0; dir<NOFACE; dir++) {
+      if ( pl->box[dir].nID < 0 || isKplane(pl, dir) || (pl->self & (1u << dir)) ) continue;
+      bp[n] = &pl->box[dir];
+      sp[n] = &sb[pl->ofs[dir]];
+      n++;
+    }
+
+    // 送信はMPI_Startallでまとめて開始
+    if ( n > 0 ) pack_Boxes(src, pl->num_compo, n, bp, sp, (const int*)NULL, (MPI_Request* const*)NULL);
+  }
+
+  if ( pl->nreq > 0 ) {
+    if ( MPI_SUCCESS != MPI_Startall(pl->nreq, pl->req) ) return false;
+  }
+
+  // 隣接ランクが自ランクの方向は、送信の開始後に配列内でコピー
+  if ( pl->self ) copy_Self(src, pl->num_compo, pl->self, pl->box);
+
+  if ( pl->nreq + pl->nreq_k > 0 ) pl->in_flight = 1;
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, float* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, double* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, int* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, unsigned* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, long long* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, signed char* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, unsigned char* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, short* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, CB_half* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, CB_bf16* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, std::complex<float>* dest);
+
+template
+bool BrickComm::Comm_plan_wait(CommPlan* pl, std::complex<double>* dest);
+
+
+/* #########################################################
+ * @brief 通信プランによる袖通信の完了待ちとunpack
+ * @param [in,out]  pl    通信プラン
+ * @param [in,out]  dest  受信する配列
+ * @retval true-success, false-fail
+ */
+template <class T>
+bool BrickComm::Comm_plan_wait(CommPlan* pl, T* dest)
+{
+  if ( !pl || !dest ) return false;
+  if ( pl->esz != sizeof(T) ) return false;
+  if ( pl->num_compo > 1 && pl->layout != vec_layout ) return false;
+
+  if ( pl->nreq + pl->nreq_k == 0 ) return true;
+  if ( !pl->in_flight ) return false;
+  if ( pl->base && pl->base != (void*)dest ) return false;
+
+  if ( MPI_SUCCESS != MPI_Waitall(pl->nreq, pl->req, MPI_STATUSES_IGNORE) ) return false;
+
+  if ( pl->mode != COMM_DTYPE ) {
+    T* rb = (T*)pl->rbuf;
+    const CommBox* bp[NOFACE];
+    const T* rp[NOFACE];
+    int n = 0;
+
+    // 面, 辺, 点の順
+    for (int dir=0; dir<NOFACE; dir++) {
+      if ( pl->box[dir].nID < 0 || isKplane(pl, dir) || (pl->self & (1u << dir)) ) continue;
+      bp[n] = &pl->box[dir];
+      rp[n] = &rb[pl->ofs[dir]];
+      n++;
+    }
+
+    if ( n > 0 ) unpack_Boxes(dest, pl->num_compo, n, bp, rp);
+  }
+
+  // K面  X, Y方向の袖を更新した後に、袖を含む平面を送受信
+  if ( pl->nreq_k > 0 ) {
+    MPI_Request* rk = &pl->req[pl->nreq];
+    if ( MPI_SUCCESS != MPI_Startall(pl->nreq_k, rk) ) return false;
+    if ( MPI_SUCCESS != MPI_Waitall(pl->nreq_k, rk, MPI_STATUSES_IGNORE) ) return false;
+  }
+  pl->in_flight = 0;
+
+  return true;
+}
@@ -0,0 +1,280 @@
+#ifndef _CB_COMM_PLAN_H_
+#define _CB_COMM_PLAN_H_
+
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/**
+ * @file   CB_CommPlan.h
+ * @brief  CommBox, CommOverlap, CommDeep, CommPlan class Header
+ */
+
+#include <mpi.h>
+#include "CB_Define.h"
+
+
+/****************************************************
+ * 隣接方向ごとの送受信領域
+ * @note インデクスはC表記、内点の先頭を0とする。終了インデクスは含まない
+ */
+class CommBox {
+public:
+  int nID;      ///< 隣接ランク番号（通信なしは-1）
+  int s_st[3];  ///< 送信領域の開始インデクス
+  int s_ed[3];  ///< 送信領域の終了インデクス
+  int r_st[3];  ///< 受信領域の開始インデクス
+  int r_ed[3];  ///< 受信領域の終了インデクス
+  int len;      ///< 1成分あたりの要素数
+
+  CommBox() {
+    nID = -1;
+    len = 0;
+    for (int i=0; i<3; i++) {
+      s_st[i] = s_ed[i] = 0;
+      r_st[i] = r_ed[i] = 0;
+    }
+  }
+};
+
+
+/****************************************************
+ * 方向ごとの送受信領域を表す派生データ型
+ * @note 要素の型、袖の層数、成分数の組み合わせごとに作成し、BrickCommで保持する
+ */
+class CommDtype {
+public:
+  MPI_Datatype base;              ///< 要素の型
+  int gc;                         ///< 通信する袖の層数
+  int nc;                         ///< 成分数
+  int layout;                     ///< 成分の並び (VECLayout)
+  MPI_Datatype s_type[NOFACE];    ///< 送信領域の型
+  MPI_Datatype r_type[NOFACE];    ///< 受信領域の型
+  MPI_Datatype k_plane;           ///< 袖を含むK方向gc枚の平面（SOAは成分ごとにストライド）
+
+  CommDtype() {
+    base = MPI_DATATYPE_NULL;
+    k_plane = MPI_DATATYPE_NULL;
+    gc = 0;
+    nc = 0;
+    layout = LAYOUT_SOA;
+    for (int i=0; i<NOFACE; i++) {
+      s_type[i] = MPI_DATATYPE_NULL;
+      r_type[i] = MPI_DATATYPE_NULL;
+    }
+  }
+
+  // 型の解放  MPI_Finalize()後は何もしない
+  void clear() {
+    int flag = 0;
+    MPI_Finalized(&flag);
+    if ( !flag ) {
+      for (int i=0; i<NOFACE; i++) {
+        if ( s_type[i] != MPI_DATATYPE_NULL ) MPI_Type_free(&s_type[i]);
+        if ( r_type[i] != MPI_DATATYPE_NULL ) MPI_Type_free(&r_type[i]);
+      }
+      if ( k_plane != MPI_DATATYPE_NULL ) MPI_Type_free(&k_plane);
+    }
+    k_plane = MPI_DATATYPE_NULL;
+    for (int i=0; i<NOFACE; i++) {
+      s_type[i] = MPI_DATATYPE_NULL;
+      r_type[i] = MPI_DATATYPE_NULL;
+    }
+    base = MPI_DATATYPE_NULL;
+    gc = 0;
+    nc = 0;
+    layout = LAYOUT_SOA;
+  }
+};
+
+
+/****************************************************
+ * 集約通信する配列のリスト
+ * @note 型の異なるスカラー、ベクトル配列を混在して登録できる
+ *       BrickComm::Comm_fields()で隣接方向ごとに1メッセージにまとめて通信する
+ */
+class CommFieldList {
+public:
+  int num;                          ///< 登録した配列数
+  void* ptr[CB_MAX_FIELD];          ///< 配列の先頭
+  MPI_Datatype dtype[CB_MAX_FIELD]; ///< 要素の型
+  int esz[CB_MAX_FIELD];            ///< 要素のバイト数
+  int nc[CB_MAX_FIELD];             ///< 成分数
+
+  CommFieldList() {
+    clear();
+  }
+
+  /*
+   * @brief 配列の登録
+   * @param [in] p         配列
+   * @param [in] num_compo 成分数 (1-scalar, 3-vector)
+   */
+  template <class T>
+  bool add(T* p, const int num_compo=1);
+
+  // 登録の解除
+  void clear() {
+    num = 0;
+    for (int i=0; i<CB_MAX_FIELD; i++) {
+      ptr[i] = NULL;
+      dtype[i] = MPI_DATATYPE_NULL;
+      esz[i] = 0;
+      nc[i] = 0;
+    }
+  }
+
+  // 1格子点あたりの全配列のバイト数
+  size_t getBytes() const {
+    size_t s = 0;
+    for (int i=0; i<num; i++) s += (size_t)esz[i] * nc[i];
+    return s;
+  }
+};
+
+
+/****************************************************
+ * 計算と袖通信をオーバーラップするための領域
+ * @note BrickComm::Comm_overlap()で通信を開始し、袖に依存しない内部領域
+ *       [ist, ied)を計算する間に通信を進める
+ *       境界領域は面ごとの板 [b_st, b_ed) に分割され（X, Y, Zの順に重複なし）、
+ *       Comm_overlap_next()は依存する方向のunpackが済んだ板の面番号を返す
+ *       内部領域と境界領域を合わせると内点[0, N)全体となる
+ *       インデクスはC表記、内点の先頭を0とする。終了インデクスは含まない
+ */
+class CommOverlap {
+public:
+  int gc;                      ///< 通信する袖の層数（ステンシルの幅）
+  int num_compo;               ///< 成分数 (1-scalar, 3-vector)
+  int in_flight;               ///< 通信中のとき1
+  int ist[3];                  ///< 内部領域の開始インデクス
+  int ied[3];                  ///< 内部領域の終了インデクス
+  int b_st[6][3];              ///< 面ごとの境界領域の開始インデクス
+  int b_ed[6][3];              ///< 面ごとの境界領域の終了インデクス
+  unsigned dep[6];             ///< 境界領域が依存する方向のビット
+  unsigned arrived;            ///< unpack済みの方向のビット
+  int done[6];                 ///< 境界領域を返したとき1
+  CommBox box[NOFACE];         ///< 方向ごとの送受信領域
+  MPI_Request req[NOFACE*2];   ///< 受信 [0, NOFACE), 送信 [NOFACE, NOFACE*2)
+
+  CommOverlap() {
+    gc = 0;
+    num_compo = 0;
+    in_flight = 0;
+    arrived = 0;
+    for (int i=0; i<3; i++) ist[i] = ied[i] = 0;
+    for (int f=0; f<6; f++) {
+      dep[f] = 0;
+      done[f] = 0;
+      for (int i=0; i<3; i++) b_st[f][i] = b_ed[f][i] = 0;
+    }
+    for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+  }
+};
+
+
+/****************************************************
+ * 深い袖による通信回避
+ * @note BrickComm::setCommDeep()で作成し、ステップごとにComm_deep()を呼ぶ
+ *       s*r層の袖をsステップに1回通信し、途中のステップは袖の内側まで
+ *       重複して計算することで、袖の有効な層をr層ずつ消費する
+ *       計算領域st, edは隣接ランクのある側のみ袖へ広がる
+ */
+class CommDeep {
+public:
+  int r;                       ///< ステンシルの幅
+  int s;                       ///< 1回の通信で進めるステップ数
+  int gc;                      ///< 通信する袖の層数 (s*r)
+  int num_compo;               ///< 成分数 (1-scalar, 3-vector)
+  int valid;                   ///< 値が有効な袖の層数（0とすると次のステップで通信）
+  int n_comm;                  ///< 通信回数
+  int n_step;                  ///< ステップ数
+  int st[3];                   ///< このステップで計算する領域の開始インデクス
+  int ed[3];                   ///< このステップで計算する領域の終了インデクス
+
+  CommDeep() {
+    r = 0;
+    s = 0;
+    gc = 0;
+    num_compo = 0;
+    valid = 0;
+    n_comm = 0;
+    n_step = 0;
+    for (int i=0; i<3; i++) st[i] = ed[i] = 0;
+  }
+};
+
+
+/****************************************************
+ * 永続通信による袖通信プラン
+ * @note BrickComm::setCommPlan()で作成し、Comm_plan()/Comm_plan_wait()で利用する
+ *       送受信バッファはプランごとに保持するので、プランは通信クラスの
+ *       バッファとは独立に利用できる
+ *       COMM_DTYPEで作成したプランはバッファを持たず、作成時の配列に束縛される
+ *       COMM_KFACEで作成したプランは、K面のリクエストをreq[nreq]以降に持ち、
+ *       作成時の配列に束縛される
+ */
+class CommPlan {
+public:
+  int gc;                      ///< 通信する袖の層数
+  int num_compo;               ///< 成分数 (1-scalar, 3-vector)
+  int layout;                  ///< 成分の並び (VECLayout)
+  int nreq;                    ///< 有効なリクエスト数
+  int nreq_k;                  ///< COMM_KFACEのK面のリクエスト数
+  int in_flight;               ///< 通信中のとき1
+  int mode;                    ///< 通信方式 (COMMmode)
+  size_t esz;                  ///< 要素のバイト数
+  MPI_Datatype dtype;          ///< 送受信データの型
+  CommBox box[NOFACE];         ///< 方向ごとの送受信領域
+  size_t ofs[NOFACE];          ///< 方向ごとのバッファ先頭（要素数）
+  unsigned self;               ///< 隣接ランクが自ランクで、配列内でコピーする方向のビット
+  char* sbuf;                  ///< 送信バッファ
+  char* rbuf;                  ///< 受信バッファ
+  void* base;                  ///< COMM_DTYPEのときの通信する配列
+  MPI_Request req[NOFACE*2];   ///< 永続リクエスト
+
+  CommPlan() {
+    gc = 0;
+    num_compo = 0;
+    layout = LAYOUT_SOA;
+    nreq = 0;
+    nreq_k = 0;
+    in_flight = 0;
+    mode = COMM_PACK;
+    esz = 0;
+    dtype = MPI_DATATYPE_NULL;
+    sbuf = NULL;
+    rbuf = NULL;
+    base = NULL;
+    self = 0;
+    for (int i=0; i<NOFACE; i++) ofs[i] = 0;
+    for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+  }
+
+  ~CommPlan() {
+    // MPI_Finalize()後はリクエストの解放を行わない
+    int flag = 0;
+    MPI_Finalized(&flag);
+    if ( !flag ) {
+      for (int i=0; i<NOFACE*2; i++) {
+        if ( req[i] != MPI_REQUEST_NULL ) MPI_Request_free(&req[i]);
+      }
+    }
+    if ( sbuf ) delete [] sbuf;
+    if ( rbuf ) delete [] rbuf;
+  }
+
+private:
+  // コピーは禁止（永続リクエストとバッファを共有するため）
+  CommPlan(const CommPlan&);
+  CommPlan& operator=(const CommPlan&);
+};
+
+#endif // _CB_COMM_PLAN_H_
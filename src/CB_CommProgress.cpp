@@ -0,0 +1,283 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommProgress.cpp
+ * @brief  BrickComm class, out-of-order unpacking for Comm_S_*, Comm_V_*
+ * @note   MPI_Waitsome/MPI_Testsomeで完了した受信から順に、面・辺・点ごとに
+ *         unpackする
+ *         受信領域が重なる方向（nodeの面と面、面と辺・点）は、従来の
+ *         X, Y, Z面、辺、点の順を保つため、先の方向のunpackを待つ
+ *         1回の完了待ちでunpackできる方向は、unpack_Boxesでまとめてunpackする
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief リクエスト番号から受信の方向を返す
+ * @param [in] idx  リクエスト番号
+ * @retval 方向、送信のときは-1
+ * @note 面は IsendIrecv() の並び {send m, recv m, send p, recv p}、
+ *       辺・点は req[dir*2] が受信
+ */
+static inline int getRecvDir(const int idx)
+{
+  if ( idx < 12 ) return ( idx % 2 == 1 ) ? idx / 2 : -1;
+  return ( idx % 2 == 0 ) ? idx / 2 : -1;
+}
+
+
+// #############################################################
+// 2つの受信領域が重なるか
+static inline bool isOverlapped(const CommBox* a, const CommBox* b)
+{
+  for (int m=0; m<3; m++) {
+    if ( a->r_st[m] >= b->r_ed[m] || b->r_st[m] >= a->r_ed[m] ) return false;
+  }
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::unpack_Arrived(float* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(double* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(int* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(short* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+template
+bool BrickComm::unpack_Arrived(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const bool block);
+
+
+/* #########################################################
+ * @brief 受信を完了した方向から順にunpack
+ * @param [in,out]  dest      受信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      block     true-全ての完了まで待つ, false-完了済みのみ
+ * @retval true-success, false-fail
+ * @note 辺・点の受信バッファは、隣接のある方向だけを詰めて並べる（box_Start()と同じ）
+ */
+template <class T>
+bool BrickComm::unpack_Arrived(T* dest,
+                               const int gc_comm,
+                               const int num_compo,
+                               MPI_Request *req,
+                               const bool block)
+{
+  CommBox box[NOFACE];
+  T* rb[NOFACE];
+
+  rb[I_minus] = (T*)f_imr;
+  rb[I_plus]  = (T*)f_ipr;
+  rb[J_minus] = (T*)f_jmr;
+  rb[J_plus]  = (T*)f_jpr;
+  rb[K_minus] = (T*)f_kmr;
+  rb[K_plus]  = (T*)f_kpr;
+
+#ifdef _DIAGONAL_COMM
+  size_t e_ptr = 0;
+  size_t c_ptr = 0;
+#endif
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    setCommBox(dir, gc_comm, &box[dir]);
+
+#ifdef _DIAGONAL_COMM
+    if ( dir >= E_mYmZ && dir <= E_pXpY ) {
+      rb[dir] = (T*)f_er + e_ptr;
+      if ( box[dir].nID >= 0 ) e_ptr += (size_t)box[dir].len * num_compo;
+    }
+    else if ( dir >= C_mXmYmZ ) {
+      rb[dir] = (T*)f_cr + c_ptr;
+      if ( box[dir].nID >= 0 ) c_ptr += (size_t)box[dir].len * num_compo;
+    }
+#endif
+  }
+
+  int idx[NOFACE*2];
+  int cnt = 0;
+
+  while (true) {
+    if ( block ) {
+      if ( MPI_SUCCESS != MPI_Waitsome(NOFACE*2, req, &cnt, idx, MPI_STATUSES_IGNORE) ) return false;
+    }
+    else {
+      if ( MPI_SUCCESS != MPI_Testsome(NOFACE*2, req, &cnt, idx, MPI_STATUSES_IGNORE) ) return false;
+    }
+
+    if ( cnt == MPI_UNDEFINED ) break;
+
+    for (int n=0; n<cnt; n++) {
+      int dir = getRecvDir(idx[n]);
+      if ( dir >= 0 ) dir_arrived |= (1u << dir);
+    }
+
+    // 先の方向と重なる場合は、先の方向のunpack後
+    // 同時にunpackできる方向は、まとめて1つの並列領域でunpackする
+    // （まとめた方向は方向の順にunpackされるので、unpack済みとみなす）
+    const CommBox* bp[NOFACE];
+    const T* rp[NOFACE];
+    int nb = 0;
+
+    for (int dir=0; dir<NOFACE; dir++) {
+      unsigned bit = 1u << dir;
+      if ( !(dir_arrived & bit) || (dir_unpacked & bit) ) continue;
+
+      bool ready = true;
+      for (int d=0; d<dir; d++) {
+        if ( box[d].nID < 0 || (dir_unpacked & (1u << d)) ) continue;
+        if ( isOverlapped(&box[d], &box[dir]) ) {
+          ready = false;
+          break;
+        }
+      }
+      if ( !ready ) continue;
+
+      bp[nb] = &box[dir];
+      rp[nb] = rb[dir];
+      nb++;
+      dir_unpacked |= bit;
+    }
+
+    if ( nb > 0 ) unpack_Boxes(dest, num_compo, nb, bp, rp);
+
+    if ( !block ) break;
+  }
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::progress(float* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(double* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(int* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(short* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+template
+bool BrickComm::progress(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req, const int prec, const unsigned mask);
+
+
+/* #########################################################
+ * @brief Comm_S_*, Comm_V_*の通信を進め、受信済みの方向をunpack
+ * @param [in,out]  dest      受信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      prec      転送精度 (PRECmode)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @retval true-success, false-fail
+ * @note COMM_PACK以外、精度を落とした転送では、MPI_Testsomeで通信を進めるだけとする
+ *       一部の方向のみの通信は、COMM_PACKと同じとする
+ *       （unpackは各方式のwaitで行う）
+ *       通信スレッドがある場合のCOMM_PACKは、何もしない
+ *       COMM_KFACEは、X, Y方向の受信が揃った時点でunpackし、K面の送信を開始する
+ */
+template <class T>
+bool BrickComm::progress(T* dest,
+                         const int gc_comm,
+                         const int num_compo,
+                         MPI_Request *req,
+                         const int prec,
+                         const unsigned mask)
+{
+  if ( !dest || !req ) return false;
+
+  const bool pack = ( comm_mode == COMM_PACK || !isAllDir(mask) ) && prec == PREC_FULL;
+
+  // 通信スレッドが進める
+  if ( pg_thread && pack ) return true;
+
+  if ( !pack ) {
+    int idx[NOFACE*2];
+    int cnt = 0;
+    MPI_Status st[NOFACE*2];
+    if ( MPI_SUCCESS != MPI_Testsome(NOFACE*2, req, &cnt, idx, st) ) return false;
+
+    // 圧縮通信は、受信したバイト数で圧縮の有無を判断するので記録しておく
+    if ( comm_mode == COMM_ZIP && prec == PREC_FULL ) {
+      for (int i=0; i<cnt; i++) {
+        if ( idx[i] % 2 == 0 ) MPI_Get_count(&st[i], MPI_BYTE, &zip_recv[idx[i]/2]);
+      }
+    }
+
+    if ( comm_mode == COMM_KFACE && prec == PREC_FULL && !kf_posted ) {
+      for (int dir=0; dir<NOFACE; dir++) {
+        int o[3];
+        getDirOffset(dir, o);
+        if ( o[2] == 0 && req[dir*2] != MPI_REQUEST_NULL ) return true;
+      }
+      return kface_Post(dest, gc_comm, num_compo, req);
+    }
+    return true;
+  }
+
+  return unpack_Arrived(dest, gc_comm, num_compo, req, false);
+}
@@ -0,0 +1,305 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommRMA.cpp
+ * @brief  BrickComm class, one-sided halo exchange with MPI_Put
+ * @note   受信バッファをMPI_Win_allocateの受信ウィンドウとして公開し、
+ *         隣接ランクはpackした送受信領域をMPI_Putで直接書き込む
+ *         同期はcomm_tblの隣接ランクのグループに限ったPSCW
+ *         (MPI_Win_post/start/complete/wait)とする
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief 受信方向ごとの領域の位置を設定
+ * @retval 全方向の領域のバイト数
+ * @note 受信方向ごとの領域は、袖を含む面の大きさで確保する
+ *       RMA、共有メモリの受信ウィンドウで共通
+ */
+MPI_Aint BrickComm::setRecvSlot()
+{
+  int gc = halo_width;
+  MPI_Aint wsz = 0;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    int o[3];
+    getDirOffset(dir, o);
+
+    MPI_Aint len = buf_compo;
+    for (int m=0; m<3; m++) len *= ( o[m] == 0 ) ? size[m] + 2*gc : gc;
+
+    rma_ofs[dir] = wsz;
+    wsz += len * sizeof(double);
+  }
+
+  return wsz;
+}
+
+
+// #############################################################
+/*
+ * @brief 隣接ランクと受信領域の位置を交換
+ * @retval true-success, false-fail
+ * @note 方向dirへの送信は、隣接ランクの反対方向の受信領域へ書き込む
+ *       受信側の局所サイズは送信側と異なるので、作成時に一度だけ交換する
+ */
+bool BrickComm::exchangeRecvSlot()
+{
+  MPI_Request req[NOFACE*2];
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    req[dir*2] = req[dir*2+1] = MPI_REQUEST_NULL;
+    rma_disp[dir] = 0;
+    if ( comm_tbl[dir] < 0 ) continue;
+
+    if ( MPI_SUCCESS != MPI_Irecv(&rma_disp[dir],
+                                  1,
+                                  MPI_AINT,
+                                  comm_tbl[dir],
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[dir*2]) ) return false;
+
+    if ( MPI_SUCCESS != MPI_Isend(&rma_ofs[dir],
+                                  1,
+                                  MPI_AINT,
+                                  comm_tbl[dir],
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &req[dir*2+1]) ) return false;
+  }
+
+  if ( MPI_SUCCESS != MPI_Waitall(NOFACE*2, req, MPI_STATUSES_IGNORE) ) return false;
+
+  return true;
+}
+
+
+// #############################################################
+/*
+ * @brief 受信ウィンドウの作成と、隣接ランクとの書き込み位置の交換
+ * @retval true-success, false-fail
+ */
+bool BrickComm::setRMAWindow()
+{
+  if ( rma_win != MPI_WIN_NULL ) return true;
+
+  MPI_Aint wsz = setRecvSlot();
+
+  if ( MPI_SUCCESS != MPI_Win_allocate(wsz,
+                                       1,
+                                       MPI_INFO_NULL,
+                                       mpi_comm,
+                                       &rma_buf,
+                                       &rma_win) ) return false;
+
+  if ( !exchangeRecvSlot() ) return false;
+
+  // 隣接ランクのグループ（重複なし）
+  int rk[NOFACE];
+  int n = 0;
+  for (int dir=0; dir<NOFACE; dir++) {
+    if ( comm_tbl[dir] < 0 ) continue;
+
+    bool found = false;
+    for (int i=0; i<n; i++) {
+      if ( rk[i] == comm_tbl[dir] ) found = true;
+    }
+    if ( !found ) rk[n++] = comm_tbl[dir];
+  }
+
+  MPI_Group grp;
+  if ( MPI_SUCCESS != MPI_Comm_group(mpi_comm, &grp) ) return false;
+  if ( MPI_SUCCESS != MPI_Group_incl(grp, n, rk, &rma_grp) ) return false;
+  MPI_Group_free(&grp);
+
+  return true;
+}
+
+
+// #############################################################
+// 受信ウィンドウの解放
+void BrickComm::freeRMAWindow()
+{
+  if ( rma_win != MPI_WIN_NULL ) MPI_Win_free(&rma_win);
+  if ( rma_grp != MPI_GROUP_NULL ) MPI_Group_free(&rma_grp);
+  rma_buf = NULL;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_rma(float* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(double* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(int* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(long long* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(short* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief 片側通信による袖通信の開始
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [out]     req       Array of MPI request (NOFACE*2)、使用しない
+ * @retval true-success, false-fail
+ * @note 受信ウィンドウは最初の通信で作成する（集団操作）
+ *       前回の通信のunpack後に受信ウィンドウを公開し(post)、隣接ランクの
+ *       公開を待って(start)書き込む
+ *       送信バッファの再利用とアクセスの終了(complete)はwaitで行う
+ */
+template <class T>
+bool BrickComm::Comm_rma(T* src,
+                         const int gc_comm,
+                         const int num_compo,
+                         MPI_Request *req)
+{
+  if ( !src || !req || buf_flag != 1 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( !isBufCompo(src, num_compo) ) return false;
+
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+
+  if ( !setRMAWindow() ) return false;
+
+  MPI_Datatype dtype = GetMPI_Datatype(src);
+
+  if ( MPI_SUCCESS != MPI_Win_post(rma_grp, 0, rma_win) ) return false;
+  if ( MPI_SUCCESS != MPI_Win_start(rma_grp, 0, rma_win) ) return false;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    pack_Box(src, num_compo, &b, (T*)cs);
+
+    int sz = b.len * num_compo;
+
+    if ( MPI_SUCCESS != MPI_Put(cs,
+                                sz,
+                                dtype,
+                                b.nID,
+                                rma_disp[dir],
+                                sz,
+                                dtype,
+                                rma_win) ) return false;
+  }
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_rma_wait(float* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(double* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(int* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(short* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_rma_wait(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief 片側通信による袖通信の完了待ち
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note 自ランクの書き込みを終了(complete)し、隣接ランクの書き込みを待って(wait)
+ *       方向の順にunpackする
+ */
+template <class T>
+bool BrickComm::Comm_rma_wait(T* dest,
+                              const int gc_comm,
+                              const int num_compo,
+                              MPI_Request *req)
+{
+  if ( !dest || !req || rma_win == MPI_WIN_NULL ) return false;
+
+  if ( MPI_SUCCESS != MPI_Win_complete(rma_win) ) return false;
+  if ( MPI_SUCCESS != MPI_Win_wait(rma_win) ) return false;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    unpack_Box(dest, num_compo, &b, (T*)(rma_buf + rma_ofs[dir]));
+  }
+
+  return true;
+}
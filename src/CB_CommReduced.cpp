@@ -0,0 +1,289 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommReduced.cpp
+ * @brief  BrickComm class, reduced-precision halo transport
+ * @note   Comm_S_*, Comm_V_*にPREC_FLOAT, PREC_BF16を指定すると、pack時に
+ *         float, bfloat16へ変換して送り、unpack時に配列の型へ戻す
+ *         変換はpack_Box, unpack_Boxのループの中で行うので、ベクトル化される
+ *         方向ごとのIsend/Irecvとし、comm_modeによらない
+ *         maskの方向から受信し、maskの反対方向へ送信する
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+// 配列の型ごとの転送する型
+// 転送できない型は配列の型のままとする（実行されないが、コンパイルできるように）
+template <class T>
+struct CB_Reduced {
+  typedef T f32;
+  typedef T b16;
+  static const bool has_f32 = false;
+  static const bool has_b16 = false;
+};
+
+template <>
+struct CB_Reduced<double> {
+  typedef float   f32;
+  typedef CB_bf16 b16;
+  static const bool has_f32 = true;
+  static const bool has_b16 = true;
+};
+
+template <>
+struct CB_Reduced<float> {
+  typedef float   f32;
+  typedef CB_bf16 b16;
+  static const bool has_f32 = false;
+  static const bool has_b16 = true;
+};
+
+
+// #############################################################
+/*
+ * @brief 転送する型Uに変換してpackし、送受信を開始
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数
+ * @param [in]      u         転送する型（型の指定のみ、NULL）
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @note バッファは8バイトの要素で確保しているので、小さい型はそのまま収まる
+ */
+template <class T, class U>
+bool BrickComm::reduced_Start(T* src,
+                              const int gc_comm,
+                              const int num_compo,
+                              U* /* u */,
+                              MPI_Request *req,
+                              const unsigned mask)
+{
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    int sz = b.len * num_compo;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    MPI_Datatype dtype = GetMPI_Datatype((U*)cs);
+
+    if ( (mask & (1u << dir)) &&
+         MPI_SUCCESS != MPI_Irecv(cr,
+                                  sz,
+                                  dtype,
+                                  b.nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[dir*2]) ) return false;
+
+    if ( !(mask & (1u << getOppositeDir(dir))) ) continue;
+
+    pack_Box(src, num_compo, &b, (U*)cs);
+
+    if ( MPI_SUCCESS != MPI_Isend(cs,
+                                  sz,
+                                  dtype,
+                                  b.nID,
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &req[dir*2+1]) ) return false;
+  }
+
+  return true;
+}
+
+
+// #############################################################
+/*
+ * @brief 受信を待ち、転送する型Uから配列の型に戻してunpack
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数
+ * @param [in]      u         転送する型（型の指定のみ、NULL）
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @note 受信領域の重なるnodeでも従来と同じ結果となるよう、方向の順にunpackする
+ */
+template <class T, class U>
+bool BrickComm::reduced_Finish(T* dest,
+                               const int gc_comm,
+                               const int num_compo,
+                               U* /* u */,
+                               MPI_Request *req,
+                               const unsigned mask)
+{
+  if ( MPI_SUCCESS != MPI_Waitall(NOFACE*2, req, MPI_STATUSES_IGNORE) ) return false;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    if ( !(mask & (1u << dir)) ) continue;
+
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    unpack_Box(dest, num_compo, &b, (const U*)cr);
+  }
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_reduced(float* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(double* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(int* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(unsigned* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(long long* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(signed char* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(unsigned char* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(short* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(CB_half* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(CB_bf16* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(std::complex<float>* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced(std::complex<double>* src, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+
+/*
+ * @brief 精度を落とした袖通信の開始
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in]      prec      転送精度 (PREC_FLOAT, PREC_BF16)
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @retval true-success, false-fail
+ * @note PREC_FLOATはdouble、PREC_BF16はdouble, floatの配列のみ
+ */
+template <class T>
+bool BrickComm::Comm_reduced(T* src,
+                             const int gc_comm,
+                             const int num_compo,
+                             const int prec,
+                             MPI_Request *req,
+                             const unsigned mask)
+{
+  if ( !src || !req || buf_flag != 1 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( !isBufCompo(src, num_compo) ) return false;
+
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+
+  typedef CB_Reduced<T> R;
+
+  if ( prec == PREC_FLOAT && R::has_f32 ) return reduced_Start(src, gc_comm, num_compo, (typename R::f32*)NULL, req, mask);
+  if ( prec == PREC_BF16 && R::has_b16 )  return reduced_Start(src, gc_comm, num_compo, (typename R::b16*)NULL, req, mask);
+
+  printf("Error : Invalid transport precision [%d]\n", prec);
+  return false;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_reduced_wait(float* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(double* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(int* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(unsigned* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(long long* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(signed char* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(unsigned char* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(short* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(CB_half* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(CB_bf16* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(std::complex<float>* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+template
+bool BrickComm::Comm_reduced_wait(std::complex<double>* dest, const int gc_comm, const int num_compo, const int prec, MPI_Request *req, const unsigned mask);
+
+
+/*
+ * @brief 精度を落とした袖通信の完了待ち
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in]      prec      転送精度 (PREC_FLOAT, PREC_BF16)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @param [in]      mask      袖を受信する方向 (DIRmask)
+ * @retval true-success, false-fail
+ * @note 開始と同じ確認を行い、対応しない型と精度の組み合わせはエラーとする
+ */
+template <class T>
+bool BrickComm::Comm_reduced_wait(T* dest,
+                                  const int gc_comm,
+                                  const int num_compo,
+                                  const int prec,
+                                  MPI_Request *req,
+                                  const unsigned mask)
+{
+  if ( !dest || !req || buf_flag != 1 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( !isBufCompo(dest, num_compo) ) return false;
+
+  typedef CB_Reduced<T> R;
+
+  if ( prec == PREC_FLOAT && R::has_f32 ) return reduced_Finish(dest, gc_comm, num_compo, (typename R::f32*)NULL, req, mask);
+  if ( prec == PREC_BF16 && R::has_b16 )  return reduced_Finish(dest, gc_comm, num_compo, (typename R::b16*)NULL, req, mask);
+
+  printf("Error : Invalid transport precision [%d]\n", prec);
+  return false;
+}
@@ -0,0 +1,300 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommShm.cpp
+ * @brief  BrickComm class, intra-node halo exchange through shared memory
+ * @note   MPI_Comm_split_type(MPI_COMM_TYPE_SHARED)で同じノードのランクを求め、
+ *         受信領域をMPI_Win_allocate_sharedの共有メモリに置く
+ *         同じノードの隣接ランクへは、送信側が配列から隣接ランクの受信領域へ
+ *         直接packするので、送信バッファとMPIによるコピーが不要となる
+ *         他ノードの隣接ランクとは、従来通りバッファを介してIsend/Irecvする
+ *         同期はノード内のMPI_Barrier（とMPI_Win_sync）とする
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief 共有メモリの受信ウィンドウの作成と、同じノードの隣接ランクの受信領域の取得
+ * @retval true-success, false-fail
+ * @note 受信領域の位置は、RMAと同じく隣接ランクと一度だけ交換する
+ *       ロードとストアで読み書きするので、作成後はMPI_Win_lock_allを保持する
+ */
+bool BrickComm::setShmWindow()
+{
+  if ( shm_win != MPI_WIN_NULL ) return true;
+
+  int myRank = 0;
+  MPI_Comm_rank(mpi_comm, &myRank);
+
+  if ( MPI_SUCCESS != MPI_Comm_split_type(mpi_comm,
+                                          MPI_COMM_TYPE_SHARED,
+                                          myRank,
+                                          MPI_INFO_NULL,
+                                          &shm_comm) ) return false;
+
+  MPI_Aint wsz = setRecvSlot();
+
+  // ランクごとの領域を各ランクに近いメモリに置く
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, (char*)"alloc_shared_noncontig", (char*)"true");
+
+  int ret = MPI_Win_allocate_shared(wsz,
+                                    1,
+                                    info,
+                                    shm_comm,
+                                    &shm_buf,
+                                    &shm_win);
+  MPI_Info_free(&info);
+  if ( MPI_SUCCESS != ret ) return false;
+
+  if ( MPI_SUCCESS != MPI_Win_lock_all(MPI_MODE_NOCHECK, shm_win) ) return false;
+
+  if ( !exchangeRecvSlot() ) return false;
+
+  // 隣接ランクのノード内のランク番号
+  MPI_Group grp, shm_grp;
+  MPI_Comm_group(mpi_comm, &grp);
+  MPI_Comm_group(shm_comm, &shm_grp);
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    shm_ptr[dir] = NULL;
+    if ( comm_tbl[dir] < 0 ) continue;
+
+    int r = MPI_UNDEFINED;
+    MPI_Group_translate_ranks(grp, 1, &comm_tbl[dir], shm_grp, &r);
+    if ( r == MPI_UNDEFINED ) continue;
+
+    MPI_Aint sz;
+    int du;
+    char* base = NULL;
+    if ( MPI_SUCCESS != MPI_Win_shared_query(shm_win, r, &sz, &du, &base) ) return false;
+
+    shm_ptr[dir] = base + rma_disp[dir];
+  }
+
+  MPI_Group_free(&grp);
+  MPI_Group_free(&shm_grp);
+
+  return true;
+}
+
+
+// #############################################################
+// 共有メモリの受信ウィンドウの解放
+void BrickComm::freeShmWindow()
+{
+  if ( shm_win != MPI_WIN_NULL ) {
+    MPI_Win_unlock_all(shm_win);
+    MPI_Win_free(&shm_win);
+  }
+  if ( shm_comm != MPI_COMM_NULL ) MPI_Comm_free(&shm_comm);
+  shm_buf = NULL;
+  for (int i=0; i<NOFACE; i++) shm_ptr[i] = NULL;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_shm(float* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(double* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(int* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(long long* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(short* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief 同じノードの隣接ランクと共有メモリで行う袖通信の開始
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note 受信ウィンドウは最初の通信で作成する（集団操作）
+ *       他ノードの送受信を先に開始し、ノード内の同期で隣接ランクが前回の
+ *       unpackを終えたことを確かめてから、受信領域へpackする
+ */
+template <class T>
+bool BrickComm::Comm_shm(T* src,
+                         const int gc_comm,
+                         const int num_compo,
+                         MPI_Request *req)
+{
+  if ( !src || !req || buf_flag != 1 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( !isBufCompo(src, num_compo) ) return false;
+
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+
+  if ( !setShmWindow() ) return false;
+
+  MPI_Datatype dtype = GetMPI_Datatype(src);
+
+  // 他ノード
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 || shm_ptr[dir] ) continue;
+
+    int sz = b.len * num_compo;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    if ( MPI_SUCCESS != MPI_Irecv(cr,
+                                  sz,
+                                  dtype,
+                                  b.nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[dir*2]) ) return false;
+
+    pack_Box(src, num_compo, &b, (T*)cs);
+
+    if ( MPI_SUCCESS != MPI_Isend(cs,
+                                  sz,
+                                  dtype,
+                                  b.nID,
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &req[dir*2+1]) ) return false;
+  }
+
+  // 同じノード
+  MPI_Win_sync(shm_win);
+  if ( MPI_SUCCESS != MPI_Barrier(shm_comm) ) return false;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 || !shm_ptr[dir] ) continue;
+
+    pack_Box(src, num_compo, &b, (T*)shm_ptr[dir]);
+  }
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_shm_wait(float* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(double* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(int* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(short* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_shm_wait(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief 同じノードの隣接ランクと共有メモリで行う袖通信の完了待ち
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note ノード内の同期で隣接ランクのpackの完了を確かめ、方向の順にunpackする
+ */
+template <class T>
+bool BrickComm::Comm_shm_wait(T* dest,
+                              const int gc_comm,
+                              const int num_compo,
+                              MPI_Request *req)
+{
+  if ( !dest || !req || shm_win == MPI_WIN_NULL ) return false;
+
+  if ( MPI_SUCCESS != MPI_Waitall(NOFACE*2, req, MPI_STATUSES_IGNORE) ) return false;
+
+  MPI_Win_sync(shm_win);
+  if ( MPI_SUCCESS != MPI_Barrier(shm_comm) ) return false;
+  MPI_Win_sync(shm_win);
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    // 同じノードの隣接ランクからは自ランクの受信ウィンドウ
+    T* rb;
+    if ( shm_ptr[dir] ) {
+      rb = (T*)(shm_buf + rma_ofs[dir]);
+    }
+    else {
+      char *cs, *cr;
+      if ( !getDirBuf(dir, &cs, &cr) ) return false;
+      rb = (T*)cr;
+    }
+
+    unpack_Box(dest, num_compo, &b, rb);
+  }
+
+  return true;
+}
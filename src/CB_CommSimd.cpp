@@ -0,0 +1,428 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommSimd.cpp
+ * @brief  BrickComm class, SIMD kernels for X-face pack/unpack
+ * @note   X面は(j,k)ごとにgc要素しか連続しないので、1行ずつでは
+ *         ベクトル化されない。複数行を1回のgather（unpackはscatter）で扱い、
+ *         バッファ側は連続なmask付きload/storeとする
+ *         1回に扱う行数は、ベクトル長に収まる行数 (VL/gc)
+ *         命令セットは実行時にCPUから選び、x86_64以外、および
+ *         2行以上収まらない場合はスカラーのループで処理する
+ *         4, 8バイトの要素はビット列のまま移すので、型によらない
+ *         スカラーのループは、通信面数1-4を固定した版に振り分ける
+ *         pack_Boxes, unpack_Boxesから、boxのj方向に並ぶ行ごとに呼ばれる
+ */
+
+#include "CB_Comm.h"
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__INTEL_COMPILER)
+#define _CB_SIMD_X86
+#include <immintrin.h>
+#endif
+
+
+// #############################################################
+// CPUが対応する命令セット
+// 静的な初期化から呼ぶので、先にCPUの情報を取得する
+static int detectSimdLevel()
+{
+#ifdef _CB_SIMD_X86
+  __builtin_cpu_init();
+  if ( __builtin_cpu_supports("avx512f") ) return SIMD_AVX512;
+  if ( __builtin_cpu_supports("avx2") )    return SIMD_AVX2;
+#endif
+  return SIMD_SCALAR;
+}
+
+
+// 選択された命令セット
+// pack中のスレッドから参照するので、実行前に決めておく
+static int simd_level = detectSimdLevel();
+
+
+#ifdef _CB_SIMD_X86
+
+// #############################################################
+// 1回のgatherで扱う行数と、レーンごとの位置 (行*stride + 列)
+static inline int setLaneOffset(const int vl, const int len, const int stride, int* ofs)
+{
+  int rows = vl / len;
+  int n = rows * len;
+
+  for (int l=0; l<vl; l++) ofs[l] = ( l < n ) ? (l / len) * stride + l % len : 0;
+
+  return rows;
+}
+
+
+// #############################################################
+// AVX-512 4バイト要素の行を集める、処理した行数を返す
+__attribute__((target("avx512f")))
+static int pack_rows4_avx512(const void* src, const int ss, void* dst, const int len, const int nrow)
+{
+  int ofs[16];
+  int rows = setLaneOffset(16, len, ss, ofs);
+  if ( rows < 2 ) return 0;
+
+  __mmask16 m = (__mmask16)( (1u << (rows * len)) - 1 );
+  __m512i idx = _mm512_loadu_si512((const void*)ofs);
+
+  const int* s = (const int*)src;
+  int*       d = (int*)dst;
+  int j = 0;
+
+  for ( ; j+rows<=nrow; j+=rows) {
+    __m512i v = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, idx, s + (size_t)j*ss, 4);
+    _mm512_mask_storeu_epi32(d + (size_t)j*len, m, v);
+  }
+
+  return j;
+}
+
+
+// AVX-512 8バイト要素の行を集める
+__attribute__((target("avx512f")))
+static int pack_rows8_avx512(const void* src, const int ss, void* dst, const int len, const int nrow)
+{
+  int ofs[8];
+  int rows = setLaneOffset(8, len, ss, ofs);
+  if ( rows < 2 ) return 0;
+
+  __mmask8 m = (__mmask8)( (1u << (rows * len)) - 1 );
+  __m256i idx = _mm256_loadu_si256((const __m256i*)ofs);
+
+  const long long* s = (const long long*)src;
+  long long*       d = (long long*)dst;
+  int j = 0;
+
+  for ( ; j+rows<=nrow; j+=rows) {
+    __m512i v = _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), m, idx, s + (size_t)j*ss, 8);
+    _mm512_mask_storeu_epi64(d + (size_t)j*len, m, v);
+  }
+
+  return j;
+}
+
+
+// AVX-512 4バイト要素の行へ配る
+__attribute__((target("avx512f")))
+static int unpack_rows4_avx512(const void* src, void* dst, const int ds, const int len, const int nrow)
+{
+  int ofs[16];
+  int rows = setLaneOffset(16, len, ds, ofs);
+  if ( rows < 2 ) return 0;
+
+  __mmask16 m = (__mmask16)( (1u << (rows * len)) - 1 );
+  __m512i idx = _mm512_loadu_si512((const void*)ofs);
+
+  const int* s = (const int*)src;
+  int*       d = (int*)dst;
+  int j = 0;
+
+  for ( ; j+rows<=nrow; j+=rows) {
+    __m512i v = _mm512_maskz_loadu_epi32(m, s + (size_t)j*len);
+    _mm512_mask_i32scatter_epi32(d + (size_t)j*ds, m, idx, v, 4);
+  }
+
+  return j;
+}
+
+
+// AVX-512 8バイト要素の行へ配る
+__attribute__((target("avx512f")))
+static int unpack_rows8_avx512(const void* src, void* dst, const int ds, const int len, const int nrow)
+{
+  int ofs[8];
+  int rows = setLaneOffset(8, len, ds, ofs);
+  if ( rows < 2 ) return 0;
+
+  __mmask8 m = (__mmask8)( (1u << (rows * len)) - 1 );
+  __m256i idx = _mm256_loadu_si256((const __m256i*)ofs);
+
+  const long long* s = (const long long*)src;
+  long long*       d = (long long*)dst;
+  int j = 0;
+
+  for ( ; j+rows<=nrow; j+=rows) {
+    __m512i v = _mm512_maskz_loadu_epi64(m, s + (size_t)j*len);
+    _mm512_mask_i32scatter_epi64(d + (size_t)j*ds, m, idx, v, 8);
+  }
+
+  return j;
+}
+
+
+// #############################################################
+// AVX2 4バイト要素の行を集める
+// AVX2にはscatterがないので、unpackはスカラーとする
+__attribute__((target("avx2")))
+static int pack_rows4_avx2(const void* src, const int ss, void* dst, const int len, const int nrow)
+{
+  int ofs[8], msk[8];
+  int rows = setLaneOffset(8, len, ss, ofs);
+  if ( rows < 2 ) return 0;
+
+  for (int l=0; l<8; l++) msk[l] = ( l < rows * len ) ? -1 : 0;
+
+  __m256i idx = _mm256_loadu_si256((const __m256i*)ofs);
+  __m256i m   = _mm256_loadu_si256((const __m256i*)msk);
+
+  const int* s = (const int*)src;
+  int*       d = (int*)dst;
+  int j = 0;
+
+  for ( ; j+rows<=nrow; j+=rows) {
+    __m256i v = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), s + (size_t)j*ss, idx, m, 4);
+    _mm256_maskstore_epi32(d + (size_t)j*len, m, v);
+  }
+
+  return j;
+}
+
+
+// AVX2 8バイト要素の行を集める
+__attribute__((target("avx2")))
+static int pack_rows8_avx2(const void* src, const int ss, void* dst, const int len, const int nrow)
+{
+  int ofs[4];
+  long long msk[4];
+  int rows = setLaneOffset(4, len, ss, ofs);
+  if ( rows < 2 ) return 0;
+
+  for (int l=0; l<4; l++) msk[l] = ( l < rows * len ) ? -1 : 0;
+
+  __m128i idx = _mm_loadu_si128((const __m128i*)ofs);
+  __m256i m   = _mm256_loadu_si256((const __m256i*)msk);
+
+  const long long* s = (const long long*)src;
+  long long*       d = (long long*)dst;
+  int j = 0;
+
+  for ( ; j+rows<=nrow; j+=rows) {
+    __m256i v = _mm256_mask_i32gather_epi64(_mm256_setzero_si256(), s + (size_t)j*ss, idx, m, 8);
+    _mm256_maskstore_epi64(d + (size_t)j*len, m, v);
+  }
+
+  return j;
+}
+
+#endif // _CB_SIMD_X86
+
+
+// #############################################################
+// スカラーで行を集める
+// 1行の要素数Nを固定すると、最内ループは展開される (N=0はlenを使う)
+template <int N, class T>
+static void pack_rows_scalar(const T* src, const int ss, T* dst, const int len, int j, const int nrow)
+{
+  const int n = ( N > 0 ) ? N : len;
+
+  for ( ; j<nrow; j++) {
+    for (int i=0; i<n; i++) {
+      dst[(size_t)j*n + i] = src[(size_t)j*ss + i];
+    }
+  }
+}
+
+
+// スカラーで行へ配る
+template <int N, class T>
+static void unpack_rows_scalar(const T* src, T* dst, const int ds, const int len, int j, const int nrow)
+{
+  const int n = ( N > 0 ) ? N : len;
+
+  for ( ; j<nrow; j++) {
+    for (int i=0; i<n; i++) {
+      dst[(size_t)j*ds + i] = src[(size_t)j*n + i];
+    }
+  }
+}
+
+
+// #############################################################
+/*
+ * @brief X面のpack, unpackに使う命令セットの設定
+ * @param [in] level  SIMDlevel
+ * @retval true-success, false-このCPUでは使えない
+ */
+bool BrickComm::setSimdLevel(const int level)
+{
+  if ( level < SIMD_SCALAR || level > detectSimdLevel() ) {
+    printf("Error : SIMD level [%d] is not supported on this CPU\n", level);
+    return false;
+  }
+
+  simd_level = level;
+  return true;
+}
+
+
+// #############################################################
+// X面のpack, unpackに使う命令セット
+int BrickComm::getSimdLevel()
+{
+  return simd_level;
+}
+
+
+// #############################################################
+template
+void BrickComm::pack_Rows(const float* src, const int ss, float* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const double* src, const int ss, double* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const int* src, const int ss, int* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const unsigned* src, const int ss, unsigned* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const long long* src, const int ss, long long* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const signed char* src, const int ss, signed char* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const unsigned char* src, const int ss, unsigned char* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const short* src, const int ss, short* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const CB_half* src, const int ss, CB_half* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const CB_bf16* src, const int ss, CB_bf16* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const std::complex<float>* src, const int ss, std::complex<float>* dst, const int len, const int nrow);
+
+template
+void BrickComm::pack_Rows(const std::complex<double>* src, const int ss, std::complex<double>* dst, const int len, const int nrow);
+
+
+/*
+ * @brief i方向にlen要素の行をnrow行、連続したバッファへ集める
+ * @param [in]  src   先頭行の先頭
+ * @param [in]  ss    行の間隔（要素数）
+ * @param [out] dst   バッファ
+ * @param [in]  len   1行の要素数（X面では通信面数）
+ * @param [in]  nrow  行数
+ * @note SIMDで扱えなかった残りの行はスカラーで処理する
+ *       lenが1-4のときは、lenを固定した版を使う
+ */
+template <class T>
+void BrickComm::pack_Rows(const T* src,
+                          const int ss,
+                          T* dst,
+                          const int len,
+                          const int nrow)
+{
+  int j = 0;
+
+#ifdef _CB_SIMD_X86
+  int lv = getSimdLevel();
+
+  if ( sizeof(T) == 4 ) {
+    if      ( lv == SIMD_AVX512 ) j = pack_rows4_avx512(src, ss, dst, len, nrow);
+    else if ( lv == SIMD_AVX2 )   j = pack_rows4_avx2(src, ss, dst, len, nrow);
+  }
+  else if ( sizeof(T) == 8 ) {
+    if      ( lv == SIMD_AVX512 ) j = pack_rows8_avx512(src, ss, dst, len, nrow);
+    else if ( lv == SIMD_AVX2 )   j = pack_rows8_avx2(src, ss, dst, len, nrow);
+  }
+#endif
+
+  switch ( len ) {
+    case 1:  pack_rows_scalar<1>(src, ss, dst, len, j, nrow); break;
+    case 2:  pack_rows_scalar<2>(src, ss, dst, len, j, nrow); break;
+    case 3:  pack_rows_scalar<3>(src, ss, dst, len, j, nrow); break;
+    case 4:  pack_rows_scalar<4>(src, ss, dst, len, j, nrow); break;
+    default: pack_rows_scalar<0>(src, ss, dst, len, j, nrow); break;
+  }
+}
+
+
+// #############################################################
+template
+void BrickComm::unpack_Rows(const float* src, float* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const double* src, double* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const int* src, int* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const unsigned* src, unsigned* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const long long* src, long long* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const signed char* src, signed char* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const unsigned char* src, unsigned char* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const short* src, short* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const CB_half* src, CB_half* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const CB_bf16* src, CB_bf16* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const std::complex<float>* src, std::complex<float>* dst, const int ds, const int len, const int nrow);
+
+template
+void BrickComm::unpack_Rows(const std::complex<double>* src, std::complex<double>* dst, const int ds, const int len, const int nrow);
+
+
+/*
+ * @brief 連続したバッファから、i方向にlen要素の行をnrow行へ配る
+ * @param [in]  src   バッファ
+ * @param [out] dst   先頭行の先頭
+ * @param [in]  ds    行の間隔（要素数）
+ * @param [in]  len   1行の要素数（X面では通信面数）
+ * @param [in]  nrow  行数
+ * @note scatterはAVX-512のみ
+ */
+template <class T>
+void BrickComm::unpack_Rows(const T* src,
+                            T* dst,
+                            const int ds,
+                            const int len,
+                            const int nrow)
+{
+  int j = 0;
+
+#ifdef _CB_SIMD_X86
+  if ( getSimdLevel() == SIMD_AVX512 ) {
+    if      ( sizeof(T) == 4 ) j = unpack_rows4_avx512(src, dst, ds, len, nrow);
+    else if ( sizeof(T) == 8 ) j = unpack_rows8_avx512(src, dst, ds, len, nrow);
+  }
+#endif
+
+  switch ( len ) {
+    case 1:  unpack_rows_scalar<1>(src, dst, ds, len, j, nrow); break;
+    case 2:  unpack_rows_scalar<2>(src, dst, ds, len, j, nrow); break;
+    case 3:  unpack_rows_scalar<3>(src, dst, ds, len, j, nrow); break;
+    case 4:  unpack_rows_scalar<4>(src, dst, ds, len, j, nrow); break;
+    default: unpack_rows_scalar<0>(src, dst, ds, len, j, nrow); break;
+  }
+}
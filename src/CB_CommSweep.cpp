@@ -0,0 +1,269 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommSweep.cpp
+ * @brief  BrickComm class, dimension-sweep halo exchange filling edges and corners
+ * @note   X面、Y面（X方向の袖を含む）、Z面（X, Y方向の袖を含む）の順に送受信すると、
+ *         辺・点の袖は面の通信で隣接ランク経由で運ばれる
+ *         斜め通信の26方向のメッセージが6方向になる
+ *         cellの辺・点の受信領域は、面の受信領域を先の方向の袖へ広げたものと一致する
+ */
+
+#include "CB_Comm.h"
+
+
+// #############################################################
+/*
+ * @brief sweepの面の送受信領域
+ * @param [in]  dir 方向 (I_minus - K_plus)
+ * @param [in]  gc  通信する袖の層数
+ * @param [out] b   送受信領域
+ * @note 先の軸は、隣接ランクのある側を袖gc層まで広げる
+ *       同じ列のランクは先の軸の隣接の有無が等しいので、送受信の大きさは一致する
+ */
+void BrickComm::setCommBox_Sweep(const int dir, const int gc, CommBox* b)
+{
+  setCommBox(dir, gc, b);
+
+  int axis = dir / 2;
+
+  for (int m=0; m<axis; m++) {
+    if ( comm_tbl[2*m]   >= 0 ) b->s_st[m] = b->r_st[m] = -gc;
+    if ( comm_tbl[2*m+1] >= 0 ) b->s_ed[m] = b->r_ed[m] = size[m] + gc;
+  }
+
+  b->len = (b->s_ed[0] - b->s_st[0]) * (b->s_ed[1] - b->s_st[1]) * (b->s_ed[2] - b->s_st[2]);
+}
+
+
+// #############################################################
+/*
+ * @brief 1方向の面の送受信を開始
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数
+ * @param [in]      axis      軸 (0-X, 1-Y, 2-Z)
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @note 受信は送信側の方向をタグとする
+ */
+template <class T>
+bool BrickComm::sweep_Start(T* src,
+                            const int gc_comm,
+                            const int num_compo,
+                            const int axis,
+                            MPI_Request *req)
+{
+  MPI_Datatype dtype = GetMPI_Datatype(src);
+
+  for (int dir=2*axis; dir<=2*axis+1; dir++) {
+    CommBox b;
+    setCommBox_Sweep(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    int sz = b.len * num_compo;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+    T* sb = (T*)cs;
+    T* rb = (T*)cr;
+
+    if ( MPI_SUCCESS != MPI_Irecv(rb,
+                                  sz,
+                                  dtype,
+                                  b.nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[dir*2]) ) return false;
+
+    pack_Box(src, num_compo, &b, sb);
+
+    if ( MPI_SUCCESS != MPI_Isend(sb,
+                                  sz,
+                                  dtype,
+                                  b.nID,
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &req[dir*2+1]) ) return false;
+  }
+
+  return true;
+}
+
+
+// #############################################################
+/*
+ * @brief 1方向の面の受信を待ち、unpack
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数
+ * @param [in]      axis      軸 (0-X, 1-Y, 2-Z)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @note 送信バッファは次の軸で使わないので、送信の完了もここで待つ
+ */
+template <class T>
+bool BrickComm::sweep_Finish(T* dest,
+                             const int gc_comm,
+                             const int num_compo,
+                             const int axis,
+                             MPI_Request *req)
+{
+  if ( MPI_SUCCESS != MPI_Waitall(4, &req[axis*4], MPI_STATUSES_IGNORE) ) return false;
+
+  for (int dir=2*axis; dir<=2*axis+1; dir++) {
+    CommBox b;
+    setCommBox_Sweep(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    unpack_Box(dest, num_compo, &b, (T*)cr);
+  }
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_sweep(float* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(double* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(int* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(long long* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(short* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief X, Y, Zの順の面の通信で辺・点も埋める袖通信の開始
+ * @param [in,out]  src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note X面の送受信を開始する
+ *       cellのみ。面のバッファはCOMM_SWEEPの大きさで確保済みであること
+ */
+template <class T>
+bool BrickComm::Comm_sweep(T* src,
+                           const int gc_comm,
+                           const int num_compo,
+                           MPI_Request *req)
+{
+  if ( !src || !req || buf_flag != 1 ) return false;
+
+  if ( grid_type != "cell" ) {
+    printf("Error : COMM_SWEEP is supported only for cell\n");
+    return false;
+  }
+  if ( !buf_sweep ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( !isBufCompo(src, num_compo) ) return false;
+
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+
+  return sweep_Start(src, gc_comm, num_compo, 0, req);
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_sweep_wait(float* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(double* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(int* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(short* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_sweep_wait(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief X, Y, Zの順の面の通信で辺・点も埋める袖通信の完了待ち
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note Y面はX面のunpack後、Z面はY面のunpack後に送受信する
+ */
+template <class T>
+bool BrickComm::Comm_sweep_wait(T* dest,
+                                const int gc_comm,
+                                const int num_compo,
+                                MPI_Request *req)
+{
+  if ( !dest || !req ) return false;
+
+  for (int axis=0; axis<3; axis++) {
+    if ( axis > 0 ) {
+      if ( !sweep_Start(dest, gc_comm, num_compo, axis, req) ) return false;
+    }
+    if ( !sweep_Finish(dest, gc_comm, num_compo, axis, req) ) return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,339 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommThread.cpp
+ * @brief  BrickComm class, asynchronous progress thread for Comm_S_*, Comm_V_*
+ * @note   MPIライブラリによっては、MPI関数を呼ばない間は通信が進まないので、
+ *         計算の間に専用のスレッドがMPI_Testsomeを繰り返し、到着した方向をunpackする
+ *         スレッドは通信がない間は条件変数で待ち、CPU時間を使わない
+ *         到着がない間はポーリング間隔をmax_usまで倍々に延ばす
+ *         計算スレッドと同時にMPI関数を呼ぶので、MPI_THREAD_MULTIPLEとする
+ *         スレッドのunpackは逐次とし、OpenMPの並列領域を開始しない
+ *         -D with_Progress=ON (_PROGRESS_THREAD) でビルドしたときのみ有効
+ */
+
+#include "CB_Comm.h"
+
+#ifdef _PROGRESS_THREAD
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _PROGRESS_THREAD
+
+// 通信スレッドの状態
+class CommProgressThread {
+public:
+  pthread_t       th;     ///< スレッド
+  pthread_mutex_t mtx;    ///< 以下のメンバとBrickCommの通信の状態を保護
+  pthread_cond_t  cond;   ///< 通信の開始、終了の通知
+  bool            quit;   ///< 終了要求
+
+  BrickComm*      comm;   ///< 通信クラス
+  void*           dest;   ///< 受信する配列
+  int             gc;     ///< 実際に通信する通信面数
+  int             nc;     ///< 成分数
+  MPI_Request*    req;    ///< 通信中のリクエスト（NULL-通信なし）
+  bool (*job)(BrickComm*, void*, const int, const int, MPI_Request*);
+
+  int             min_us; ///< 最短のポーリング間隔 [usec]
+  int             max_us; ///< 最長のポーリング間隔 [usec]
+};
+
+#else
+
+class CommProgressThread {};
+
+#endif // _PROGRESS_THREAD
+
+
+
+// #############################################################
+/*
+ * @brief 通信スレッドの開始
+ * @param [in] min_us 到着があったときのポーリング間隔 [usec] (0-sched_yield)
+ * @param [in] max_us 到着がないときに倍々に延ばすポーリング間隔の上限 [usec]
+ * @param [in] cpu    スレッドを固定するCPU番号 (-1-固定しない)
+ * @retval true-success, false-fail
+ */
+bool BrickComm::startProgressThread(const int min_us, const int max_us, const int cpu)
+{
+#ifdef _PROGRESS_THREAD
+  if ( pg_thread ) return true;
+  if ( min_us < 0 || max_us < min_us ) return false;
+
+  // 計算スレッドのMPI関数と同時にスレッドから呼ぶ
+  int provided = MPI_THREAD_SINGLE;
+  MPI_Query_thread(&provided);
+  if ( provided < MPI_THREAD_MULTIPLE ) {
+    printf("Error : startProgressThread() needs MPI_THREAD_MULTIPLE\n");
+    return false;
+  }
+
+  CommProgressThread* p = new CommProgressThread;
+  p->quit   = false;
+  p->comm   = this;
+  p->dest   = NULL;
+  p->gc     = 0;
+  p->nc     = 0;
+  p->req    = NULL;
+  p->job    = NULL;
+  p->min_us = min_us;
+  p->max_us = max_us;
+
+  pthread_mutex_init(&p->mtx, NULL);
+  pthread_cond_init(&p->cond, NULL);
+
+  if ( 0 != pthread_create(&p->th, NULL, progress_Main, p) ) {
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->mtx);
+    delete p;
+    return false;
+  }
+
+#ifdef __linux__
+  // 計算スレッドと別のコアに固定
+  if ( cpu >= 0 ) {
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    CPU_SET(cpu, &cs);
+    pthread_setaffinity_np(p->th, sizeof(cpu_set_t), &cs);
+  }
+#endif
+
+  pg_thread = p;
+  return true;
+
+#else
+  (void)min_us;
+  (void)max_us;
+  (void)cpu;
+  printf("Error : startProgressThread() is not supported. Build with -D with_Progress=ON\n");
+  return false;
+#endif
+}
+
+
+// #############################################################
+// 通信スレッドの終了
+void BrickComm::stopProgressThread()
+{
+#ifdef _PROGRESS_THREAD
+  if ( !pg_thread ) return;
+
+  CommProgressThread* p = pg_thread;
+
+  pthread_mutex_lock(&p->mtx);
+  p->quit = true;
+  pthread_cond_signal(&p->cond);
+  pthread_mutex_unlock(&p->mtx);
+
+  pthread_join(p->th, NULL);
+
+  pthread_cond_destroy(&p->cond);
+  pthread_mutex_destroy(&p->mtx);
+  delete p;
+
+  pg_thread = NULL;
+#endif
+}
+
+
+// #############################################################
+template
+void BrickComm::progress_Post(float* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(double* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(int* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(short* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+void BrickComm::progress_Post(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/*
+ * @brief 通信スレッドに開始した通信を渡す
+ * @param [in,out]  dest      受信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @note スレッドがない場合は何もしない
+ */
+template <class T>
+void BrickComm::progress_Post(T* dest,
+                              const int gc_comm,
+                              const int num_compo,
+                              MPI_Request *req)
+{
+#ifdef _PROGRESS_THREAD
+  if ( !pg_thread ) return;
+
+  CommProgressThread* p = pg_thread;
+
+  pthread_mutex_lock(&p->mtx);
+  p->dest = dest;
+  p->gc   = gc_comm;
+  p->nc   = num_compo;
+  p->req  = req;
+  p->job  = progress_Job<T>;
+  pthread_cond_signal(&p->cond);
+  pthread_mutex_unlock(&p->mtx);
+#else
+  (void)dest;
+  (void)gc_comm;
+  (void)num_compo;
+  (void)req;
+#endif
+}
+
+
+// #############################################################
+/*
+ * @brief 通信スレッドから通信を取り戻す
+ * @note スレッドはロック中のみ通信の状態を触るので、ロックを取れば
+ *       処理の途中ではない
+ */
+void BrickComm::progress_Cancel()
+{
+#ifdef _PROGRESS_THREAD
+  if ( !pg_thread ) return;
+
+  CommProgressThread* p = pg_thread;
+
+  pthread_mutex_lock(&p->mtx);
+  p->req = NULL;
+  p->job = NULL;
+  pthread_mutex_unlock(&p->mtx);
+#endif
+}
+
+
+// #############################################################
+/*
+ * @brief 通信スレッドが行う1回分の処理
+ * @param [in]      c         通信クラス
+ * @param [in,out]  dest      受信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ */
+template <class T>
+bool BrickComm::progress_Job(BrickComm* c,
+                             void* dest,
+                             const int gc_comm,
+                             const int num_compo,
+                             MPI_Request *req)
+{
+  return c->unpack_Arrived((T*)dest, gc_comm, num_compo, req, false);
+}
+
+
+// #############################################################
+/*
+ * @brief 通信スレッドの本体
+ * @param [in] arg CommProgressThread
+ * @note 全てのリクエストが完了したら通信を手放す
+ *       残りのunpackはないので、waitはリクエストの確認のみとなる
+ */
+void* BrickComm::progress_Main(void* arg)
+{
+#ifdef _PROGRESS_THREAD
+  CommProgressThread* p = (CommProgressThread*)arg;
+  int wait_us = p->min_us;
+
+  // 計算スレッドの並列領域と重なるので、unpackは逐次
+  setSerialPack(true);
+
+  pthread_mutex_lock(&p->mtx);
+
+  while ( !p->quit ) {
+
+    // 通信がなければ、開始か終了の通知を待つ
+    if ( !p->job ) {
+      pthread_cond_wait(&p->cond, &p->mtx);
+      wait_us = p->min_us;
+      continue;
+    }
+
+    unsigned done = p->comm->dir_unpacked;
+
+    bool fin = true;
+    if ( p->job(p->comm, p->dest, p->gc, p->nc, p->req) ) {
+      for (int i=0; i<NOFACE*2; i++) {
+        if ( p->req[i] != MPI_REQUEST_NULL ) fin = false;
+      }
+    }
+
+    // 完了、またはエラーの場合はwaitに任せる
+    if ( fin ) {
+      p->req = NULL;
+      p->job = NULL;
+      continue;
+    }
+
+    // 到着がなければポーリング間隔を延ばす
+    if ( p->comm->dir_unpacked != done ) {
+      wait_us = p->min_us;
+    }
+    else {
+      wait_us = ( wait_us < 1 ) ? 1 : wait_us * 2;
+      if ( wait_us > p->max_us ) wait_us = p->max_us;
+    }
+
+    pthread_mutex_unlock(&p->mtx);
+
+    if ( wait_us > 0 ) {
+      usleep(wait_us);
+    }
+    else {
+      sched_yield();
+    }
+
+    pthread_mutex_lock(&p->mtx);
+  }
+
+  pthread_mutex_unlock(&p->mtx);
+#else
+  (void)arg;
+#endif
+
+  return NULL;
+}
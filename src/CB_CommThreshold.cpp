@@ -0,0 +1,165 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommThreshold.cpp
+ * @brief  BrickComm class, serial/parallel threshold of pack and unpack
+ * @note   1回のpack, unpackの大きさが閾値未満のときは、OpenMPの並列領域を
+ *         開始せずに逐次に処理する。小さな部分領域では、並列領域の開始・終了が
+ *         コピーそのものより高くつく
+ *         閾値は最初のinit()で、逐次と並列のコピーの時間を比べて決める
+ *         環境変数 CB_PACK_PAR_BYTES、setParallelThreshold()で上書きできる
+ */
+
+#include "CB_Comm.h"
+#include <stdlib.h>
+
+// 計測する大きさの範囲（バイト）と繰り返し回数
+#define CB_PROBE_MIN  1024
+#define CB_PROBE_MAX  (1024*1024)
+#define CB_PROBE_REP  8
+
+
+// 並列に処理する最小の大きさ（バイト）、負は未設定
+// pack中のスレッドから参照するので、通信の前に決めておく
+static long par_bytes = -1;
+
+// 呼び出したスレッドのpack, unpackを逐次とする（通信スレッド）
+static thread_local bool serial_pack = false;
+
+
+#ifdef _OPENMP
+// #############################################################
+// 逐次と並列のコピーを比べ、並列が速くなる最小の大きさ
+static long probeThreshold()
+{
+  long th = 2 * CB_PROBE_MAX;  // 計測した範囲では逐次が速い
+
+  size_t n = CB_PROBE_MAX / sizeof(double);
+  double* a = new double[n];
+  double* b = new double[n];
+
+#pragma omp parallel for
+  for (long i=0; i<(long)n; i++) {
+    a[i] = (double)i;
+    b[i] = 0.0;
+  }
+
+  for (long sz=CB_PROBE_MIN; sz<=CB_PROBE_MAX; sz*=2) {
+    long m = sz / (long)sizeof(double);
+    double ts = DBL_MAX;
+    double tp = DBL_MAX;
+
+    for (int r=0; r<CB_PROBE_REP; r++) {
+      double t0 = MPI_Wtime();
+      for (long i=0; i<m; i++) b[i] = a[i];
+
+      double t1 = MPI_Wtime();
+#pragma omp parallel for
+      for (long i=0; i<m; i++) b[i] = a[i];
+
+      double t2 = MPI_Wtime();
+      if ( t1 - t0 < ts ) ts = t1 - t0;
+      if ( t2 - t1 < tp ) tp = t2 - t1;
+    }
+
+    if ( tp < ts ) {
+      th = sz;
+      break;
+    }
+  }
+
+  // コピーを省かれないよう、結果を参照する
+  volatile double sink = b[n-1];
+  (void)sink;
+
+  delete [] a;
+  delete [] b;
+
+  return th;
+}
+#endif // _OPENMP
+
+
+// #############################################################
+/*
+ * @brief 閾値が未設定なら、環境変数 CB_PACK_PAR_BYTES または計測で決める
+ * @note 1スレッドでは計測せず、未設定のままとする
+ */
+void BrickComm::calibrateThreshold()
+{
+  if ( par_bytes >= 0 ) return;
+
+  const char* env = getenv("CB_PACK_PAR_BYTES");
+  if ( env ) {
+    char* e;
+    long v = strtol(env, &e, 10);
+    if ( e != env && *e == '\0' && v >= 0 ) {
+      par_bytes = v;
+      return;
+    }
+    printf("Error : Invalid CB_PACK_PAR_BYTES [%s]\n", env);
+  }
+
+#ifdef _OPENMP
+  if ( omp_get_max_threads() > 1 ) par_bytes = probeThreshold();
+#endif
+}
+
+
+// #############################################################
+/*
+ * @brief pack, unpackを並列に処理する最小の大きさの設定
+ * @param [in] bytes  1回のpack, unpackの大きさ（バイト）、0は常に並列
+ * @retval true-success, false-fail
+ */
+bool BrickComm::setParallelThreshold(const long bytes)
+{
+  if ( bytes < 0 ) {
+    printf("Error : Invalid parallel threshold [%ld]\n", bytes);
+    return false;
+  }
+
+  par_bytes = bytes;
+  return true;
+}
+
+
+// #############################################################
+// pack, unpackを並列に処理する最小の大きさ
+long BrickComm::getParallelThreshold()
+{
+  return par_bytes;
+}
+
+
+// #############################################################
+/*
+ * @brief 並列領域を開始するか
+ * @param [in] bytes  1回のpack, unpackの大きさ（バイト）
+ */
+bool BrickComm::isParallelPack(const size_t bytes)
+{
+  if ( serial_pack ) return false;
+  return ( par_bytes < 0 || bytes >= (size_t)par_bytes );
+}
+
+
+// #############################################################
+/*
+ * @brief 呼び出したスレッドのpack, unpackを逐次とする
+ * @param [in] flag  true-逐次, false-閾値による
+ * @note 通信スレッドは計算スレッドと並行して動くので、並列領域を開始しない
+ */
+void BrickComm::setSerialPack(const bool flag)
+{
+  serial_pack = flag;
+}
@@ -0,0 +1,485 @@
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_CommZip.cpp
+ * @brief  BrickComm class, halo exchange with lossless compression
+ * @note   packしたメッセージを、前の値とのXOR、バイトごとの面への分解(shuffle)、
+ *         0バイトの省略の順に可逆圧縮して送る
+ *         滑らかな場では、XORの上位バイト（符号・指数・上位の仮数）がほぼ0となる
+ *         CB_ZIP_CHUNK要素ごとに独立に圧縮し、チャンクをOpenMPで並列に処理する
+ *
+ *         圧縮したメッセージ
+ *           [チャンク数 (uint32)] [チャンクごとのバイト数 (uint32)] [チャンク]...
+ *         チャンク
+ *           バイト面0から順に、8要素ごとに [0でないバイトのビット] [0でないバイト]...
+ *
+ *         圧縮後が元より小さいときのみ圧縮したメッセージを送るので、受信側は
+ *         受信したバイト数で圧縮の有無を判断する
+ */
+
+#include "CB_Comm.h"
+#include <string.h>
+#include <stdint.h>
+
+
+// #############################################################
+// 1チャンクのバイト数の上限
+static inline size_t zipChunkBound(const size_t n, const size_t esz)
+{
+  return esz * (n + (n + 7) / 8);
+}
+
+
+// #############################################################
+// メッセージのバイト数の上限
+static inline size_t zipBound(const size_t n, const size_t esz)
+{
+  size_t nch = (n + CB_ZIP_CHUNK - 1) / CB_ZIP_CHUNK;
+  return sizeof(uint32_t) * (1 + nch) + zipChunkBound(n, esz);
+}
+
+
+// #############################################################
+/*
+ * @brief 1チャンクの圧縮
+ * @param [in]  x   入力
+ * @param [in]  n   要素数 (<= CB_ZIP_CHUNK)
+ * @param [out] out 出力、NULLのときはバイト数のみ数える
+ * @retval 出力のバイト数
+ */
+template <class U>
+static size_t zipChunk(const U* x, const size_t n, unsigned char* out)
+{
+  U d[CB_ZIP_CHUNK];
+
+  // 前の値とのXOR
+  d[0] = x[0];
+  for (size_t i=1; i<n; i++) d[i] = x[i] ^ x[i-1];
+
+  size_t p = 0;
+
+  for (size_t b=0; b<sizeof(U); b++) {
+    int sh = 8 * (int)b;
+
+    for (size_t g=0; g<n; g+=8) {
+      size_t m = ( n - g < 8 ) ? n - g : 8;
+
+      size_t q = p++;
+      unsigned char mask = 0;
+      for (size_t k=0; k<m; k++) {
+        unsigned char c = (unsigned char)((d[g+k] >> sh) & 0xff);
+        if ( !c ) continue;
+        mask |= (unsigned char)(1u << k);
+        if ( out ) out[p] = c;
+        p++;
+      }
+      if ( out ) out[q] = mask;
+    }
+  }
+
+  return p;
+}
+
+
+// #############################################################
+/*
+ * @brief 1チャンクの展開
+ * @param [in]  in  入力
+ * @param [in]  n   要素数 (<= CB_ZIP_CHUNK)
+ * @param [out] x   出力
+ */
+template <class U>
+static void unzipChunk(const unsigned char* in, const size_t n, U* x)
+{
+  for (size_t i=0; i<n; i++) x[i] = 0;
+
+  size_t p = 0;
+
+  for (size_t b=0; b<sizeof(U); b++) {
+    int sh = 8 * (int)b;
+
+    for (size_t g=0; g<n; g+=8) {
+      size_t m = ( n - g < 8 ) ? n - g : 8;
+
+      unsigned char mask = in[p++];
+      for (size_t k=0; k<m; k++) {
+        if ( mask & (1u << k) ) x[g+k] |= (U)in[p++] << sh;
+      }
+    }
+  }
+
+  // XORを戻す
+  for (size_t i=1; i<n; i++) x[i] ^= x[i-1];
+}
+
+
+// #############################################################
+/*
+ * @brief メッセージの圧縮
+ * @param [in]  x     入力
+ * @param [in]  n     要素数
+ * @param [out] out   出力
+ * @param [in]  limit 出力のバイト数の上限
+ * @retval 出力のバイト数、limit以上になる場合は0
+ * @note チャンクのバイト数を数えてから、並列に書き込む
+ */
+template <class U>
+static size_t zipMessage(const U* x, const size_t n, char* out, const size_t limit)
+{
+  int nch = (int)((n + CB_ZIP_CHUNK - 1) / CB_ZIP_CHUNK);
+
+  uint32_t* hd = (uint32_t*)out;
+  hd[0] = (uint32_t)nch;
+
+#pragma omp parallel for schedule(static)
+  for (int c=0; c<nch; c++) {
+    size_t st = (size_t)c * CB_ZIP_CHUNK;
+    size_t m  = ( n - st < CB_ZIP_CHUNK ) ? n - st : CB_ZIP_CHUNK;
+    hd[1+c] = (uint32_t)zipChunk(x + st, m, (unsigned char*)NULL);
+  }
+
+  size_t total = sizeof(uint32_t) * (1 + nch);
+  for (int c=0; c<nch; c++) total += hd[1+c];
+  if ( total >= limit ) return 0;
+
+  unsigned char* body = (unsigned char*)out + sizeof(uint32_t) * (1 + nch);
+
+#pragma omp parallel for schedule(static)
+  for (int c=0; c<nch; c++) {
+    size_t ofs = 0;
+    for (int i=0; i<c; i++) ofs += hd[1+i];
+
+    size_t st = (size_t)c * CB_ZIP_CHUNK;
+    size_t m  = ( n - st < CB_ZIP_CHUNK ) ? n - st : CB_ZIP_CHUNK;
+    zipChunk(x + st, m, body + ofs);
+  }
+
+  return total;
+}
+
+
+// #############################################################
+/*
+ * @brief メッセージの展開
+ * @param [in]  in  入力
+ * @param [in]  n   要素数
+ * @param [out] x   出力
+ */
+template <class U>
+static void unzipMessage(const char* in, const size_t n, U* x)
+{
+  const uint32_t* hd = (const uint32_t*)in;
+  int nch = (int)hd[0];
+
+  const unsigned char* body = (const unsigned char*)in + sizeof(uint32_t) * (1 + nch);
+
+#pragma omp parallel for schedule(static)
+  for (int c=0; c<nch; c++) {
+    size_t ofs = 0;
+    for (int i=0; i<c; i++) ofs += hd[1+i];
+
+    size_t st = (size_t)c * CB_ZIP_CHUNK;
+    size_t m  = ( n - st < CB_ZIP_CHUNK ) ? n - st : CB_ZIP_CHUNK;
+    unzipChunk(body + ofs, m, x + st);
+  }
+}
+
+
+// #############################################################
+/*
+ * @brief 圧縮通信の設定
+ * @param [in] threshold 圧縮するメッセージの最小のバイト数
+ * @param [in] ratio     圧縮後/圧縮前がこれ以下のときに圧縮したメッセージを送る
+ * @retval true-success, false-fail
+ */
+bool BrickComm::setCompress(const size_t threshold, const double ratio)
+{
+  if ( ratio <= 0.0 || ratio > 1.0 ) {
+    printf("Error : Invalid compression ratio [%f]\n", ratio);
+    return false;
+  }
+
+  zip_threshold = threshold;
+  zip_ratio = ratio;
+  for (int i=0; i<NOFACE; i++) zip_skip[i] = 0;
+
+  return true;
+}
+
+
+// #############################################################
+/*
+ * @brief 圧縮通信の統計
+ * @param [out] raw  圧縮前の送信バイト数の合計
+ * @param [out] sent 実際に送信したバイト数の合計
+ */
+void BrickComm::getCompressStat(size_t* raw, size_t* sent)
+{
+  *raw  = zip_raw;
+  *sent = zip_sent;
+}
+
+
+// #############################################################
+/*
+ * @brief 圧縮通信の送受信領域の確保
+ * @retval true-success, false-fail
+ * @note 方向ごとに、init()の成分数で面の最大の大きさの圧縮後の上限を確保する
+ */
+bool BrickComm::setZipBuffer()
+{
+  if ( zip_buf ) return true;
+
+  int gc = halo_width;
+  size_t total = 0;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    int o[3];
+    getDirOffset(dir, o);
+
+    size_t len = buf_compo;
+    for (int m=0; m<3; m++) len *= ( o[m] == 0 ) ? size[m] + 2*gc : gc;
+
+    zip_ofs[dir] = total;
+    zip_cap[dir] = (zipBound(len, sizeof(double)) + CB_BUF_ALIGN - 1) / CB_BUF_ALIGN * CB_BUF_ALIGN;
+    total += zip_cap[dir] * 2;
+  }
+
+  if ( !(zip_buf = new char [total]) ) return false;
+
+  return true;
+}
+
+
+// #############################################################
+// 圧縮通信の送受信領域の解放
+void BrickComm::freeZipBuffer()
+{
+  if ( zip_buf ) delete [] zip_buf;
+  zip_buf = NULL;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_zip(float* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(double* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(int* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(unsigned* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(long long* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(signed char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(unsigned char* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(short* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(CB_half* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(CB_bf16* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(std::complex<float>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip(std::complex<double>* src, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief 圧縮した袖通信の開始
+ * @param [in]      src       通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [out]     req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note zip_threshold以上の方向を圧縮する
+ *       圧縮率がzip_ratioを超えた方向は、CB_ZIP_RETRY回の通信の間は圧縮しない
+ */
+template <class T>
+bool BrickComm::Comm_zip(T* src,
+                         const int gc_comm,
+                         const int num_compo,
+                         MPI_Request *req)
+{
+  if ( !src || !req || buf_flag != 1 ) return false;
+  if ( gc_comm < 1 || gc_comm > halo_width ) return false;
+  if ( !isBufCompo(src, num_compo) ) return false;
+  if ( sizeof(T) != 4 && sizeof(T) != 8 ) return false;
+
+  for (int i=0; i<NOFACE*2; i++) req[i] = MPI_REQUEST_NULL;
+  for (int i=0; i<NOFACE; i++) zip_recv[i] = -1;
+
+  if ( !setZipBuffer() ) return false;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    size_t n = (size_t)b.len * num_compo;
+    size_t raw = n * sizeof(T);
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    char* zs = zip_buf + zip_ofs[dir];
+    char* zr = zs + zip_cap[dir];
+
+    // 大きさの分からない受信は上限で待つ
+    if ( MPI_SUCCESS != MPI_Irecv(zr,
+                                  (int)zip_cap[dir],
+                                  MPI_BYTE,
+                                  b.nID,
+                                  getTag(getOppositeDir(dir)),
+                                  mpi_comm,
+                                  &req[dir*2]) ) return false;
+
+    pack_Box(src, num_compo, &b, (T*)cs);
+
+    // 圧縮が見合う場合のみ圧縮したメッセージ
+    char* sb = cs;
+    size_t sz = raw;
+
+    if ( raw >= zip_threshold && zip_skip[dir] == 0 ) {
+      size_t limit = (size_t)(raw * zip_ratio);
+      if ( limit >= raw ) limit = raw;
+
+      size_t zsz = ( sizeof(T) == 8 ) ? zipMessage((const uint64_t*)cs, n, zs, limit)
+                                      : zipMessage((const uint32_t*)cs, n, zs, limit);
+      if ( zsz > 0 ) {
+        sb = zs;
+        sz = zsz;
+      }
+      else {
+        zip_skip[dir] = CB_ZIP_RETRY;
+      }
+    }
+    else if ( zip_skip[dir] > 0 ) {
+      zip_skip[dir]--;
+    }
+
+    zip_raw  += raw;
+    zip_sent += sz;
+
+    if ( MPI_SUCCESS != MPI_Isend(sb,
+                                  (int)sz,
+                                  MPI_BYTE,
+                                  b.nID,
+                                  getTag(dir),
+                                  mpi_comm,
+                                  &req[dir*2+1]) ) return false;
+  }
+
+  return true;
+}
+
+
+// #############################################################
+template
+bool BrickComm::Comm_zip_wait(float* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(double* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(int* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(unsigned* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(long long* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(signed char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(unsigned char* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(short* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(CB_half* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(CB_bf16* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(std::complex<float>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+template
+bool BrickComm::Comm_zip_wait(std::complex<double>* dest, const int gc_comm, const int num_compo, MPI_Request *req);
+
+
+/* #########################################################
+ * @brief 圧縮した袖通信の完了待ち
+ * @param [in,out]  dest      通信する配列
+ * @param [in]      gc_comm   実際に通信する通信面数
+ * @param [in]      num_compo 成分数 (1-scalar, 3-vector)
+ * @param [in,out]  req       Array of MPI request (NOFACE*2)
+ * @retval true-success, false-fail
+ * @note 受信したバイト数が元の大きさより小さい方向を展開し、方向の順にunpackする
+ *       waitの前にprogress()で完了した受信は、そこで記録したバイト数を使う
+ */
+template <class T>
+bool BrickComm::Comm_zip_wait(T* dest,
+                              const int gc_comm,
+                              const int num_compo,
+                              MPI_Request *req)
+{
+  if ( !dest || !req || !zip_buf ) return false;
+
+  MPI_Status st[NOFACE*2];
+  if ( MPI_SUCCESS != MPI_Waitall(NOFACE*2, req, st) ) return false;
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    if ( zip_recv[dir] < 0 ) MPI_Get_count(&st[dir*2], MPI_BYTE, &zip_recv[dir]);
+  }
+
+  for (int dir=0; dir<NOFACE; dir++) {
+    CommBox b;
+    setCommBox(dir, gc_comm, &b);
+    if ( b.nID < 0 ) continue;
+
+    size_t n = (size_t)b.len * num_compo;
+
+    char *cs, *cr;
+    if ( !getDirBuf(dir, &cs, &cr) ) return false;
+
+    char* zr = zip_buf + zip_ofs[dir] + zip_cap[dir];
+
+    T* rb = (T*)zr;
+    if ( (size_t)zip_recv[dir] < n * sizeof(T) ) {
+      if ( sizeof(T) == 8 ) unzipMessage(zr, n, (uint64_t*)cr);
+      else                  unzipMessage(zr, n, (uint32_t*)cr);
+      rb = (T*)cr;
+    }
+
+    unpack_Box(dest, num_compo, &b, rb);
+  }
+
+  return true;
+}
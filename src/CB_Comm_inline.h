@@ -17,7 +17,48 @@
  * @brief  BrickComm class inline Header
  */
 
-#include <typeinfo>
+// #############################################################
+/*
+ * @brief 要素の型に対応するMPI_Datatype
+ * @note 型ごとの特殊化でコンパイル時に決まる
+ *       特殊化のない型は、BrickComm::registerType()で登録した派生データ型とする
+ */
+template <class T>
+struct CB_MPIType {
+  static MPI_Datatype& user()
+  {
+    static MPI_Datatype t = MPI_DATATYPE_NULL;
+    return t;
+  }
+
+  static MPI_Datatype get() { return user(); }
+};
+
+template <class T>
+struct CB_MPIType<const T> : public CB_MPIType<T> {};
+
+template <> struct CB_MPIType<char>                 { static MPI_Datatype get() { return MPI_CHAR; } };
+template <> struct CB_MPIType<signed char>          { static MPI_Datatype get() { return MPI_SIGNED_CHAR; } };
+template <> struct CB_MPIType<unsigned char>        { static MPI_Datatype get() { return MPI_UNSIGNED_CHAR; } };
+template <> struct CB_MPIType<short>                { static MPI_Datatype get() { return MPI_SHORT; } };
+template <> struct CB_MPIType<unsigned short>       { static MPI_Datatype get() { return MPI_UNSIGNED_SHORT; } };
+template <> struct CB_MPIType<int>                  { static MPI_Datatype get() { return MPI_INT; } };
+template <> struct CB_MPIType<unsigned>             { static MPI_Datatype get() { return MPI_UNSIGNED; } };
+template <> struct CB_MPIType<long>                 { static MPI_Datatype get() { return MPI_LONG; } };
+template <> struct CB_MPIType<unsigned long>        { static MPI_Datatype get() { return MPI_UNSIGNED_LONG; } };
+#ifdef MPI_LONG_LONG
+template <> struct CB_MPIType<long long>            { static MPI_Datatype get() { return MPI_LONG_LONG; } };
+#endif
+#ifdef MPI_UNSIGNED_LONG_LONG
+template <> struct CB_MPIType<unsigned long long>   { static MPI_Datatype get() { return MPI_UNSIGNED_LONG_LONG; } };
+#endif
+template <> struct CB_MPIType<float>                { static MPI_Datatype get() { return MPI_FLOAT; } };
+template <> struct CB_MPIType<double>               { static MPI_Datatype get() { return MPI_DOUBLE; } };
+template <> struct CB_MPIType<CB_half>              { static MPI_Datatype get() { return MPI_UNSIGNED_SHORT; } };
+template <> struct CB_MPIType<CB_bf16>              { static MPI_Datatype get() { return MPI_UNSIGNED_SHORT; } };
+template <> struct CB_MPIType<std::complex<float> > { static MPI_Datatype get() { return MPI_C_FLOAT_COMPLEX; } };
+template <> struct CB_MPIType<std::complex<double> >{ static MPI_Datatype get() { return MPI_C_DOUBLE_COMPLEX; } };
+
 
 // #############################################################
 // MPI_Datatypeを取得
@@ -29,33 +70,42 @@ MPI_Datatype BrickComm::GetMPI_Datatype( T *ptr )
     return MPI_DATATYPE_NULL;
   }
   
-  //  if     ( typeid(ptr) == typeid(char*)  )              return MPI_CHAR;
-  //  else if( typeid(ptr) == typeid(short*) )              return MPI_SHORT;
-  if     ( typeid(ptr) == typeid(int*) )                return MPI_INT;
-  else if( typeid(ptr) == typeid(long*) )               return MPI_LONG;
-  else if( typeid(ptr) == typeid(float*) )              return MPI_FLOAT;
-  else if( typeid(ptr) == typeid(double*) )             return MPI_DOUBLE;
-  //  else if( typeid(ptr) == typeid(long double*) )        return MPI_LONG_DOUBLE;
-  //  else if( typeid(ptr) == typeid(unsigned char*) )      return MPI_UNSIGNED_CHAR;
-  //  else if( typeid(ptr) == typeid(unsigned short*) )     return MPI_UNSIGNED_SHORT;
-  else if( typeid(ptr) == typeid(unsigned*) )           return MPI_UNSIGNED;
-  else if( typeid(ptr) == typeid(unsigned int*) )       return MPI_UNSIGNED;
-  else if( typeid(ptr) == typeid(unsigned long*) )      return MPI_UNSIGNED_LONG;
-  //#ifdef MPI_LONG_LONG_INT
-  //  else if( typeid(ptr) == typeid(long long int*) )      return MPI_LONG_LONG_INT;
-  //#endif
-#ifdef MPI_LONG_LONG
-   else if( typeid(ptr) == typeid(long long*) )          return MPI_LONG_LONG;
-#endif
-  //#ifdef MPI_UNSIGNED_LONG_LONG
-  //  else if( typeid(ptr) == typeid(unsigned long long*) ) return MPI_UNSIGNED_LONG_LONG;
-  //#endif
-  else {
+  MPI_Datatype t = CB_MPIType<T>::get();
+  
+  if ( t == MPI_DATATYPE_NULL ) {
     printf("CBrick error : MPI_DATATYPE_NULL\n");
     exit(-1);
   }
   
-  return MPI_DATATYPE_NULL;
+  return t;
+}
+
+
+// #############################################################
+/*
+ * @brief 利用者の型Tに、コミット済みの派生データ型を対応付ける
+ * @param [in] dtype  コミット済みの派生データ型
+ * @retval true-success, false-fail
+ * @note 大きさ、範囲（extent）はsizeof(T)、下限は0とする
+ */
+template <class T> inline
+bool BrickComm::registerType(MPI_Datatype dtype)
+{
+  if ( dtype == MPI_DATATYPE_NULL ) return false;
+  
+  int sz;
+  MPI_Aint lb, ext;
+  if ( MPI_SUCCESS != MPI_Type_size(dtype, &sz) ) return false;
+  if ( MPI_SUCCESS != MPI_Type_get_extent(dtype, &lb, &ext) ) return false;
+  
+  if ( (size_t)sz != sizeof(T) || (size_t)ext != sizeof(T) || lb != 0 ) {
+    printf("Error : Datatype size %d / extent %ld does not match the element size %zu\n",
+           sz, (long)ext, sizeof(T));
+    return false;
+  }
+  
+  CB_MPIType<T>::user() = dtype;
+  return true;
 }
 
 
@@ -69,6 +119,7 @@ bool BrickComm::IsendIrecv(T* ms,
                            int msz,
                            int nIDm,
                            int nIDp,
+                           int dir_m,
                            MPI_Request *req)
 {
   if( !ms || !mr || !ps || !pr ) return false;
@@ -78,7 +129,7 @@ bool BrickComm::IsendIrecv(T* ms,
   
   return IsendIrecv(dtype,
                     (void*)ms, (void*)mr, (void*)ps, (void*)pr,
-                    msz, nIDm, nIDp, req);
+                    msz, nIDm, nIDp, dir_m, req);
 }
 
 
@@ -88,6 +139,7 @@ template <class T> inline
 bool BrickComm::IrecvData(T* ptr,
                           int sz,
                           int nID,
+                          int tag,
                           MPI_Request *req)
 {
   if( !ptr ) return false;
@@ -95,7 +147,7 @@ bool BrickComm::IrecvData(T* ptr,
   MPI_Datatype dtype = BrickComm::GetMPI_Datatype(ptr);
   if( dtype == MPI_DATATYPE_NULL ) return false;
   
-  return IrecvData(dtype, (void*)ptr, sz, nID, req);
+  return IrecvData(dtype, (void*)ptr, sz, nID, tag, req);
 }
 
 
@@ -105,6 +157,7 @@ template <class T> inline
 bool BrickComm::IsendData(T* ptr,
                           int sz,
                           int nID,
+                          int tag,
                           MPI_Request *req)
 {
   if( !ptr ) return false;
@@ -112,7 +165,28 @@ bool BrickComm::IsendData(T* ptr,
   MPI_Datatype dtype = BrickComm::GetMPI_Datatype(ptr);
   if( dtype == MPI_DATATYPE_NULL ) return false;
   
-  return IsendData(dtype, (void*)ptr, sz, nID, req);
+  return IsendData(dtype, (void*)ptr, sz, nID, tag, req);
+}
+
+
+// #############################################################
+// 集約通信する配列の登録
+template <class T> inline
+bool CommFieldList::add(T* p, const int num_compo)
+{
+  if ( !p || num_compo < 1 || num >= CB_MAX_FIELD ) return false;
+  if ( sizeof(T) != 1 && sizeof(T) != 2 && sizeof(T) != 4 && sizeof(T) != 8 && sizeof(T) != 16 ) return false;
+
+  MPI_Datatype t = BrickComm::GetMPI_Datatype(p);
+  if ( t == MPI_DATATYPE_NULL ) return false;
+
+  ptr[num]   = (void*)p;
+  dtype[num] = t;
+  esz[num]   = sizeof(T);
+  nc[num]    = num_compo;
+  num++;
+
+  return true;
 }
 
 
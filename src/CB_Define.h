@@ -83,6 +83,91 @@ enum DIRection {
 };
 
 
+// 袖通信する方向のマスク (ビットの組み合わせ、ビット位置はDIRection)
+// マスクの方向の袖を受信し、反対方向へ送信する（全ランクで同じマスクを与える）
+// 辺・点のビットは_DIAGONAL_COMMのときのみ有効
+enum DIRmask {
+  DIR_I_MINUS = 1 << 0,
+  DIR_I_PLUS  = 1 << 1,
+  DIR_J_MINUS = 1 << 2,
+  DIR_J_PLUS  = 1 << 3,
+  DIR_K_MINUS = 1 << 4,
+  DIR_K_PLUS  = 1 << 5,
+  DIR_X       = DIR_I_MINUS | DIR_I_PLUS, // X方向の面
+  DIR_Y       = DIR_J_MINUS | DIR_J_PLUS, // Y方向の面
+  DIR_Z       = DIR_K_MINUS | DIR_K_PLUS, // Z方向の面
+  DIR_FACE    = 0x3f,                     // 全ての面
+  DIR_EDGE    = 0xfff << 6,               // 全ての辺
+  DIR_CORNER  = 0xff << 18,               // 全ての点
+  DIR_ALL     = DIR_FACE | DIR_EDGE | DIR_CORNER
+};
+
+
+// 袖通信の方式
+enum COMMmode {
+  COMM_PACK=0,  // バッファへpack/unpackして送受信
+  COMM_DTYPE,   // 派生データ型で配列から直接送受信
+  COMM_KFACE,   // K面は袖を含む平面を配列から直接送受信、その他はpack/unpack
+  COMM_SWEEP,   // X, Y, Zの順に先の方向の袖を含めて面を送受信し、辺・点も埋める (cell)
+  COMM_NEIGHBOR,// 全方向をpackし、近傍集団通信 MPI_Ineighbor_alltoallw 1回で送受信
+  COMM_RMA,     // 隣接ランクの受信ウィンドウへMPI_Putで書き込み、PSCWで同期
+  COMM_SHM,     // 同じノードの隣接ランクは共有メモリの受信領域へ直接pack、その他はpack/unpack
+  COMM_ZIP      // packしたメッセージを可逆圧縮して送受信
+};
+
+// 袖通信の転送精度
+enum PRECmode {
+  PREC_FULL=0,  // 配列の型のまま
+  PREC_FLOAT,   // floatに変換して送受信 (double)
+  PREC_BF16     // bfloat16に変換して送受信 (double, float)
+};
+
+
+// ベクトル配列の成分の並び
+enum VECLayout {
+  LAYOUT_SOA=0, // v(i,j,k,l) 成分が最外
+  LAYOUT_AOS    // v(l,i,j,k) 成分が最内
+};
+
+
+// 通信バッファの確保方法 (ビットの組み合わせ)
+enum BUFoption {
+  BUF_DEFAULT=0,  // mallocでページ境界に確保
+  BUF_MPIMEM=1,   // MPI_Alloc_memで確保（NICに登録済みのメモリ）
+  BUF_HUGEPAGE=2  // huge page境界に確保し、huge pageを要求 (Linux)
+};
+
+
+// X面のpack, unpackに使う命令セット
+enum SIMDlevel {
+  SIMD_SCALAR=0,  // SIMD命令を使わない
+  SIMD_AVX2,      // AVX2のgather
+  SIMD_AVX512     // AVX-512のgather, scatter
+};
+
+
+// X面のpack, unpackで1回に扱う行数（j方向）
+#define CB_PACK_ROWS 32
+
+
+// 通信バッファの方向ごとの境界、ページ、huge pageの大きさ [byte]
+#define CB_BUF_ALIGN      64
+#define CB_PAGE_SIZE      4096
+#define CB_HUGE_PAGE_SIZE 2097152
+
+
+// 圧縮通信のチャンクの要素数、圧縮を見送る通信回数
+#define CB_ZIP_CHUNK 4096
+#define CB_ZIP_RETRY 16
+
+
+// 派生データ型のキャッシュ数
+#define CB_DTYPE_CACHE 8
+
+// 集約通信で登録できる配列数
+#define CB_MAX_FIELD 16
+
+
 
 
 
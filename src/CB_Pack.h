@@ -16,6 +16,8 @@
  * @brief  Packing header
  */
 
+#include <string.h>
+
 
 
 /* バッファへのインデクス変換 (I方向)
@@ -145,4 +147,127 @@
 + _IDX_SK(_I,_J,_K,_NI,_NJ) \
 )
 
+
+/* 袖を含む配列の1次元インデクス (_IDX_V3Dと同じ並び)
+ * @note ストライドを構築時に求めるので、ループの中はi, j, k, lとの積和となり、
+ *       コンパイラが加算に置き換えられる
+ *       袖幅0とすると、CommBoxのバッファの並びとなる
+ */
+class CB_Index {
+public:
+  const int    vc;  ///< 袖幅
+  const size_t sj;  ///< j方向のストライド
+  const size_t sk;  ///< k方向のストライド
+  const size_t sl;  ///< 成分のストライド
+
+  constexpr CB_Index(const int ni, const int nj, const int nk, const int m_vc)
+    : vc(m_vc),
+      sj((size_t)(ni+2*m_vc)),
+      sk((size_t)(ni+2*m_vc) * (nj+2*m_vc)),
+      sl((size_t)(ni+2*m_vc) * (nj+2*m_vc) * (nk+2*m_vc)) {}
+
+  constexpr size_t operator()(const int i, const int j, const int k, const int l=0) const
+  {
+    return (size_t)l * sl + (size_t)(k+vc) * sk + (size_t)(j+vc) * sj + (size_t)(i+vc);
+  }
+};
+
+
+/* bfloat16 (floatの上位16ビット)
+ * @note 精度を落とした袖通信(PREC_BF16)の転送に用いる
+ *       floatからは最近接偶数への丸め、NaNはquiet NaNのまま保つ
+ *       分岐のない整数演算なので、pack/unpackのループでベクトル化される
+ */
+struct CB_bf16 {
+  unsigned short v;
+
+  CB_bf16() {}
+
+  CB_bf16(const float f)
+  {
+    unsigned u;
+    memcpy(&u, &f, sizeof(u));
+    unsigned nan = ( (u & 0x7fffffffu) > 0x7f800000u ) ? 0x00400000u : 0u;
+    u = ( u | nan ) + ( nan ? 0u : 0x7fffu + ((u >> 16) & 1u) );
+    v = (unsigned short)(u >> 16);
+  }
+
+  operator float() const
+  {
+    unsigned u = (unsigned)v << 16;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+  }
+};
+
+
+/* IEEE 754 半精度 (binary16)
+ * @note 袖通信の要素の型として、16ビットのまま転送する
+ *       floatからは最近接偶数への丸め、範囲外は無限大、NaNはquiet NaNとする
+ */
+struct CB_half {
+  unsigned short v;
+
+  CB_half() {}
+
+  CB_half(const float f)
+  {
+    unsigned u;
+    memcpy(&u, &f, sizeof(u));
+    unsigned sgn = u & 0x80000000u;
+    u ^= sgn;
+
+    unsigned h;
+    if ( u >= 0x47800000u ) {
+      // 無限大, NaN
+      h = ( u > 0x7f800000u ) ? 0x7e00u : 0x7c00u;
+    }
+    else if ( u < 0x38800000u ) {
+      // 非正規化数, 0  仮数の下位に揃えて、浮動小数点の加算で丸める
+      const unsigned magic = ((127 - 15) + (23 - 10) + 1) << 23;
+      float a, m;
+      memcpy(&a, &u, sizeof(a));
+      memcpy(&m, &magic, sizeof(m));
+      a += m;
+      memcpy(&h, &a, sizeof(h));
+      h -= magic;
+    }
+    else {
+      // 正規化数
+      unsigned odd = (u >> 13) & 1u;
+      u += ((unsigned)(15 - 127) << 23) + 0xfffu + odd;
+      h = u >> 13;
+    }
+    v = (unsigned short)(h | (sgn >> 16));
+  }
+
+  operator float() const
+  {
+    const unsigned shifted_exp = 0x7c00u << 13;
+    unsigned u = ((unsigned)v & 0x7fffu) << 13;
+    unsigned e = u & shifted_exp;
+    u += (unsigned)(127 - 15) << 23;
+
+    float f;
+    if ( e == shifted_exp ) {
+      // 無限大, NaN
+      u += (unsigned)(128 - 16) << 23;
+    }
+    else if ( e == 0 ) {
+      // 非正規化数, 0
+      const unsigned magic = 113u << 23;
+      float m;
+      u += 1u << 23;
+      memcpy(&f, &u, sizeof(f));
+      memcpy(&m, &magic, sizeof(m));
+      f -= m;
+      memcpy(&u, &f, sizeof(u));
+    }
+    u |= ((unsigned)v & 0x8000u) << 16;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+  }
+};
+
 #endif // _CB_PACK_H_
@@ -0,0 +1,573 @@
+#ifndef _CB_PACK_BOX_H_
+#define _CB_PACK_BOX_H_
+
+/*
+###################################################################################
+#
+# CBrick
+#
+# Copyright (c) 2017-2020 Research Institute for Information Technology(RIIT),
+#                    Kyushu University.  All rights reserved.
+#
+####################################################################################
+*/
+
+/*
+ * @file   CB_PackingBox.h
+ * @brief  BrickComm class
+ * @note   CommBoxで指定される直方体領域のpack/unpack
+ *         バッファの並びは成分が最外、i方向が最内となる
+ *         バッファの型が配列と異なる場合は、pack/unpackの中で変換する
+ *         インデクスはCB_Indexで求め、ストライドをループの外に出す
+ *         LAYOUT_AOSでは、配列・バッファとも成分を最内とする
+ *         pack_Boxes, unpack_Boxesは、面・辺・点の全boxを1つの並列領域で扱い、
+ *         各スレッドの担当行はpack_Rows, unpack_Rowsで処理する
+ *         大きさがisParallelPack()の閾値未満のときは、並列領域を開始しない
+ *         copy_Boxは、隣接ランクが自ランクの方向を配列内で直接コピーする
+ */
+
+
+// #########################################################
+/*
+ * @brief pack send data of the box
+ * @param [in]  array    source array
+ * @param [in]  nc       number of components
+ * @param [in]  b        send/recv box
+ * @param [out] sendbuf  send buffer
+ * @note i方向の長さ（X面では通信面数）が1-4のときは、長さを固定した版で
+ *       最内ループを展開する
+ */
+template <class T, class U> inline
+void BrickComm::pack_Box(const T *array,
+                         const int nc,
+                         const CommBox *b,
+                         U *sendbuf)
+{
+  switch ( b->s_ed[0] - b->s_st[0] ) {
+    case 1:  pack_BoxN<1>(array, nc, b, sendbuf); break;
+    case 2:  pack_BoxN<2>(array, nc, b, sendbuf); break;
+    case 3:  pack_BoxN<3>(array, nc, b, sendbuf); break;
+    case 4:  pack_BoxN<4>(array, nc, b, sendbuf); break;
+    default: pack_BoxN<0>(array, nc, b, sendbuf); break;
+  }
+}
+
+
+// #########################################################
+/*
+ * @brief unpack recv data of the box
+ * @param [out] array    dest array
+ * @param [in]  nc       number of components
+ * @param [in]  b        send/recv box
+ * @param [in]  recvbuf  recv buffer
+ */
+template <class T, class U> inline
+void BrickComm::unpack_Box(T *array,
+                           const int nc,
+                           const CommBox *b,
+                           const U *recvbuf)
+{
+  switch ( b->r_ed[0] - b->r_st[0] ) {
+    case 1:  unpack_BoxN<1>(array, nc, b, recvbuf); break;
+    case 2:  unpack_BoxN<2>(array, nc, b, recvbuf); break;
+    case 3:  unpack_BoxN<3>(array, nc, b, recvbuf); break;
+    case 4:  unpack_BoxN<4>(array, nc, b, recvbuf); break;
+    default: unpack_BoxN<0>(array, nc, b, recvbuf); break;
+  }
+}
+
+
+// #########################################################
+/*
+ * @brief pack send data of the box with fixed i-length
+ * @param [in]  array    source array
+ * @param [in]  nc       number of components
+ * @param [in]  b        send/recv box
+ * @param [out] sendbuf  send buffer
+ * @note N>0のときi方向の長さはN、N=0のときはboxから求める
+ */
+template <int N, class T, class U> inline
+void BrickComm::pack_BoxN(const T *array,
+                          const int nc,
+                          const CommBox *b,
+                          U *sendbuf)
+{
+  int is = b->s_st[0];
+  int js = b->s_st[1];
+  int ks = b->s_st[2];
+  const int ni = ( N > 0 ) ? N : b->s_ed[0] - is;
+  int nj = b->s_ed[1] - js;
+  int nk = b->s_ed[2] - ks;
+
+  const CB_Index A(size[0], size[1], size[2], halo_width);
+  const CB_Index B(ni, nj, nk, 0);
+
+  // 成分が最内の並びでは、i方向の行の全成分が連続
+  if ( vec_layout == LAYOUT_AOS && nc > 1 ) {
+    const int nr = ni * nc;
+
+#pragma omp parallel for collapse(2) if( isParallelPack((size_t)ni * nj * nk * nc * sizeof(T)) )
+    for( int k=0; k<nk; k++ ){
+      for( int j=0; j<nj; j++ ){
+        const T* s = &array[A(is,js+j,ks+k) * nc];
+        U*       d = &sendbuf[B(0,j,k) * nc];
+        #pragma ivdep
+        for( int m=0; m<nr; m++ ){
+          d[m] = (U)s[m];
+        }
+      }
+    }
+    return;
+  }
+
+#pragma omp parallel for collapse(3) if( isParallelPack((size_t)ni * nj * nk * nc * sizeof(T)) )
+  for (int l=0; l<nc; l++) {
+    for( int k=0; k<nk; k++ ){
+      for( int j=0; j<nj; j++ ){
+        #pragma ivdep
+        for( int i=0; i<ni; i++ ){
+          sendbuf[B(i,j,k,l)] = (U)array[A(is+i,js+j,ks+k,l)];
+        }
+      }
+    }
+  }
+}
+
+
+// #########################################################
+/*
+ * @brief unpack recv data of the box with fixed i-length
+ * @param [out] array    dest array
+ * @param [in]  nc       number of components
+ * @param [in]  b        send/recv box
+ * @param [in]  recvbuf  recv buffer
+ * @note N>0のときi方向の長さはN、N=0のときはboxから求める
+ */
+template <int N, class T, class U> inline
+void BrickComm::unpack_BoxN(T *array,
+                            const int nc,
+                            const CommBox *b,
+                            const U *recvbuf)
+{
+  int is = b->r_st[0];
+  int js = b->r_st[1];
+  int ks = b->r_st[2];
+  const int ni = ( N > 0 ) ? N : b->r_ed[0] - is;
+  int nj = b->r_ed[1] - js;
+  int nk = b->r_ed[2] - ks;
+
+  const CB_Index A(size[0], size[1], size[2], halo_width);
+  const CB_Index B(ni, nj, nk, 0);
+
+  // 成分が最内の並びでは、i方向の行の全成分が連続
+  if ( vec_layout == LAYOUT_AOS && nc > 1 ) {
+    const int nr = ni * nc;
+
+#pragma omp parallel for collapse(2) if( isParallelPack((size_t)ni * nj * nk * nc * sizeof(T)) )
+    for( int k=0; k<nk; k++ ){
+      for( int j=0; j<nj; j++ ){
+        const U* s = &recvbuf[B(0,j,k) * nc];
+        T*       d = &array[A(is,js+j,ks+k) * nc];
+        #pragma ivdep
+        for( int m=0; m<nr; m++ ){
+          d[m] = (T)s[m];
+        }
+      }
+    }
+    return;
+  }
+
+#pragma omp parallel for collapse(3) if( isParallelPack((size_t)ni * nj * nk * nc * sizeof(T)) )
+  for (int l=0; l<nc; l++) {
+    for( int k=0; k<nk; k++ ){
+      for( int j=0; j<nj; j++ ){
+        #pragma ivdep
+        for( int i=0; i<ni; i++ ){
+          array[A(is+i,js+j,ks+k,l)] = (T)recvbuf[B(i,j,k,l)];
+        }
+      }
+    }
+  }
+}
+
+
+// #########################################################
+/*
+ * @brief boxの行の数と1行の要素数
+ * @param [in]  st    開始インデクス
+ * @param [in]  ed    終了インデクス
+ * @param [in]  nc    number of components
+ * @param [out] rows  行数
+ * @param [out] rlen  1行の要素数
+ * @note 行は(l,k,j)ごと、LAYOUT_AOSでは成分を含めて(k,j)ごととし、
+ *       バッファ上ではr行目がr*rlenから連続する
+ */
+inline void BrickComm::getBoxRows(const int* st,
+                                  const int* ed,
+                                  const int nc,
+                                  size_t* rows,
+                                  size_t* rlen) const
+{
+  size_t ni = ed[0] - st[0];
+  size_t nj = ed[1] - st[1];
+  size_t nk = ed[2] - st[2];
+
+  if ( vec_layout == LAYOUT_AOS && nc > 1 ) {
+    *rows = nj * nk;
+    *rlen = ni * nc;
+  }
+  else {
+    *rows = nj * nk * nc;
+    *rlen = ni;
+  }
+}
+
+
+// #########################################################
+/*
+ * @brief boxのr行目の先頭の、配列上の位置
+ * @param [in]  st    開始インデクス
+ * @param [in]  ed    終了インデクス
+ * @param [in]  nc    number of components
+ * @param [in]  r     行番号
+ */
+inline size_t BrickComm::getBoxRowOffset(const int* st,
+                                         const int* ed,
+                                         const int nc,
+                                         const size_t r) const
+{
+  const CB_Index A(size[0], size[1], size[2], halo_width);
+  size_t nj = ed[1] - st[1];
+  size_t nk = ed[2] - st[2];
+  int j = (int)(r % nj);
+  size_t q = r / nj;
+
+  if ( vec_layout == LAYOUT_AOS && nc > 1 ) {
+    return A(st[0], st[1]+j, st[2]+(int)q) * nc;
+  }
+  return A(st[0], st[1]+j, st[2]+(int)(q % nk), (int)(q / nk));
+}
+
+
+// #########################################################
+/*
+ * @brief 要素の通し番号[lo, hi)に先頭のある行の範囲[r0, r1)
+ * @param [in]  ofs   boxの先頭の通し番号
+ * @param [in]  rows  boxの行数
+ * @param [in]  rlen  1行の要素数
+ * @param [in]  lo    範囲の先頭
+ * @param [in]  hi    範囲の末尾
+ * @param [out] r0    先頭の行
+ * @param [out] r1    末尾の行の次
+ */
+static inline void getRowRange(const size_t ofs,
+                               const size_t rows,
+                               const size_t rlen,
+                               const size_t lo,
+                               const size_t hi,
+                               size_t* r0,
+                               size_t* r1)
+{
+  *r0 = ( lo > ofs ) ? (lo - ofs + rlen - 1) / rlen : 0;
+  *r1 = ( hi > ofs ) ? (hi - ofs + rlen - 1) / rlen : 0;
+  if ( *r0 > rows ) *r0 = rows;
+  if ( *r1 > rows ) *r1 = rows;
+}
+
+
+// #########################################################
+/*
+ * @brief boxの行[r0, r1)をpack
+ * @param [in]  array  source array
+ * @param [in]  nc     number of components
+ * @param [in]  b      send/recv box
+ * @param [in]  r0     先頭の行
+ * @param [in]  r1     末尾の行の次
+ * @param [out] buf    boxの送信バッファの先頭
+ * @note j方向に並ぶ行は配列上の間隔が一定なので、pack_Rows()でまとめて集める
+ *       X面のような短い行はSIMD、1-4要素の行は長さを固定した版で処理される
+ */
+template <class T> inline
+void BrickComm::pack_BoxRows(const T *array,
+                             const int nc,
+                             const CommBox *b,
+                             const size_t r0,
+                             const size_t r1,
+                             T *buf)
+{
+  size_t rows, rlen;
+  getBoxRows(b->s_st, b->s_ed, nc, &rows, &rlen);
+
+  const size_t nj = b->s_ed[1] - b->s_st[1];
+  const int ss = ( size[0] + 2*halo_width ) * ( ( vec_layout == LAYOUT_AOS && nc > 1 ) ? nc : 1 );
+
+  for (size_t r=r0; r<r1; ) {
+    size_t e = ( r / nj + 1 ) * nj; // 同じk（成分）の行の末尾
+    if ( e > r1 ) e = r1;
+    pack_Rows(&array[getBoxRowOffset(b->s_st, b->s_ed, nc, r)], ss, &buf[r * rlen], (int)rlen, (int)(e - r));
+    r = e;
+  }
+}
+
+
+// #########################################################
+/*
+ * @brief boxの行[r0, r1)をunpack
+ * @param [out] array  dest array
+ * @param [in]  nc     number of components
+ * @param [in]  b      send/recv box
+ * @param [in]  r0     先頭の行
+ * @param [in]  r1     末尾の行の次
+ * @param [in]  buf    boxの受信バッファの先頭
+ */
+template <class T> inline
+void BrickComm::unpack_BoxRows(T *array,
+                               const int nc,
+                               const CommBox *b,
+                               const size_t r0,
+                               const size_t r1,
+                               const T *buf)
+{
+  size_t rows, rlen;
+  getBoxRows(b->r_st, b->r_ed, nc, &rows, &rlen);
+
+  const size_t nj = b->r_ed[1] - b->r_st[1];
+  const int ds = ( size[0] + 2*halo_width ) * ( ( vec_layout == LAYOUT_AOS && nc > 1 ) ? nc : 1 );
+
+  for (size_t r=r0; r<r1; ) {
+    size_t e = ( r / nj + 1 ) * nj;
+    if ( e > r1 ) e = r1;
+    unpack_Rows(&buf[r * rlen], &array[getBoxRowOffset(b->r_st, b->r_ed, nc, r)], ds, (int)rlen, (int)(e - r));
+    r = e;
+  }
+}
+
+
+// #########################################################
+/*
+ * @brief 複数のboxを1つの並列領域でpackし、packを終えたboxから送信
+ * @param [in]  array    source array
+ * @param [in]  nc       number of components
+ * @param [in]  n        number of boxes
+ * @param [in]  b        boxes
+ * @param [out] buf      boxごとの送信バッファ
+ * @param [in]  dir      boxごとの方向（タグ）
+ * @param [out] req      boxごとの送信の要求、NULLのときはpackのみ
+ * @retval true-success, false-fail
+ * @note 全boxの要素数を行単位でスレッドに静的に等分する
+ *       全boxの大きさが閾値未満のときは、逐次にpackし、boxごとに送信する
+ *       送信する場合は、スレッド0が末尾の担当分をpackした後に送信を受け持ち、
+ *       担当スレッドが全てpackを終えたboxから順にMPI_Isendを呼ぶ
+ *       （MPIの呼び出しは並列領域を開始したスレッドのみ）
+ */
+template <class T> inline
+bool BrickComm::pack_Boxes(const T *array,
+                           const int nc,
+                           const int n,
+                           const CommBox* const* b,
+                           T* const* buf,
+                           const int* dir,
+                           MPI_Request* const* req)
+{
+  size_t rows[NOFACE], rlen[NOFACE], ofs[NOFACE+1];
+  int left[NOFACE];  // packの残りの行数
+
+  ofs[0] = 0;
+  for (int q=0; q<n; q++) {
+    getBoxRows(b[q]->s_st, b[q]->s_ed, nc, &rows[q], &rlen[q]);
+    ofs[q+1] = ofs[q] + rows[q] * rlen[q];
+    left[q] = (int)rows[q];
+  }
+
+  MPI_Datatype dtype = GetMPI_Datatype((T*)array);
+  bool post = ( req != NULL );
+  bool ok = true;
+
+#pragma omp parallel if( isParallelPack(ofs[n] * sizeof(T)) )
+  {
+    int tid = 0;
+    int np  = 1;
+#ifdef _OPENMP
+    tid = omp_get_thread_num();
+    np  = omp_get_num_threads();
+#endif
+
+    if ( np == 1 ) {
+      for (int q=0; q<n; q++) {
+        pack_BoxRows(array, nc, b[q], 0, rows[q], buf[q]);
+
+        if ( post && MPI_SUCCESS != MPI_Isend(buf[q],
+                                              (int)(ofs[q+1] - ofs[q]),
+                                              dtype,
+                                              b[q]->nID,
+                                              getTag(dir[q]),
+                                              mpi_comm,
+                                              req[q]) ) ok = false;
+      }
+    }
+    else {
+      // 送信する場合、スレッド0は末尾を担当し、先頭のboxの送信を遅らせない
+      int w = post ? (tid + np - 1) % np : tid;
+      size_t lo = ofs[n] * w / np;
+      size_t hi = ofs[n] * (w+1) / np;
+
+      for (int q=0; q<n; q++) {
+        size_t r0, r1;
+        getRowRange(ofs[q], rows[q], rlen[q], lo, hi, &r0, &r1);
+        if ( r1 <= r0 ) continue;
+
+        pack_BoxRows(array, nc, b[q], r0, r1, buf[q]);
+
+        if ( post ) {
+          int done = (int)(r1 - r0);
+#pragma omp flush
+#pragma omp atomic
+          left[q] -= done;
+        }
+      }
+
+      if ( post && tid == 0 ) {
+        // 送信スレッド
+        bool sent[NOFACE];
+        int  cnt = 0;
+        for (int q=0; q<n; q++) sent[q] = false;
+
+        while ( cnt < n ) {
+          for (int q=0; q<n; q++) {
+            if ( sent[q] ) continue;
+
+            int v;
+#pragma omp atomic read
+            v = left[q];
+            if ( v > 0 ) continue;
+#pragma omp flush
+
+            if ( MPI_SUCCESS != MPI_Isend(buf[q],
+                                          (int)(ofs[q+1] - ofs[q]),
+                                          dtype,
+                                          b[q]->nID,
+                                          getTag(dir[q]),
+                                          mpi_comm,
+                                          req[q]) ) ok = false;
+            sent[q] = true;
+            cnt++;
+          }
+        }
+      }
+    }
+  }
+
+  return ok;
+}
+
+
+// #########################################################
+/*
+ * @brief 複数のboxを1つの並列領域でunpack
+ * @param [out] array    dest array
+ * @param [in]  nc       number of components
+ * @param [in]  n        number of boxes
+ * @param [in]  b        boxes
+ * @param [in]  buf      boxごとの受信バッファ
+ * @note cellでは全boxの要素数を行単位でスレッドに静的に等分する
+ *       受信領域が重なるnodeでは、boxの順（方向の順）にboxごとに行を等分し、
+ *       boxの間で同期する
+ */
+template <class T> inline
+void BrickComm::unpack_Boxes(T *array,
+                             const int nc,
+                             const int n,
+                             const CommBox* const* b,
+                             const T* const* buf)
+{
+  size_t rows[NOFACE], rlen[NOFACE], ofs[NOFACE+1];
+
+  ofs[0] = 0;
+  for (int q=0; q<n; q++) {
+    getBoxRows(b[q]->r_st, b[q]->r_ed, nc, &rows[q], &rlen[q]);
+    ofs[q+1] = ofs[q] + rows[q] * rlen[q];
+  }
+
+  bool ordered = ( grid_type == "node" );
+
+#pragma omp parallel if( isParallelPack(ofs[n] * sizeof(T)) )
+  {
+    int tid = 0;
+    int np  = 1;
+#ifdef _OPENMP
+    tid = omp_get_thread_num();
+    np  = omp_get_num_threads();
+#endif
+
+    if ( ordered ) {
+      for (int q=0; q<n; q++) {
+        size_t r0 = rows[q] * tid / np;
+        size_t r1 = rows[q] * (tid+1) / np;
+        if ( r1 > r0 ) unpack_BoxRows(array, nc, b[q], r0, r1, buf[q]);
+#pragma omp barrier
+      }
+    }
+    else {
+      size_t lo = ofs[n] * tid / np;
+      size_t hi = ofs[n] * (tid+1) / np;
+
+      for (int q=0; q<n; q++) {
+        size_t r0, r1;
+        getRowRange(ofs[q], rows[q], rlen[q], lo, hi, &r0, &r1);
+        if ( r1 > r0 ) unpack_BoxRows(array, nc, b[q], r0, r1, buf[q]);
+      }
+    }
+  }
+}
+
+
+// #########################################################
+/*
+ * @brief 配列内で、送信領域から受信領域へ直接コピー
+ * @param [in,out] array  array
+ * @param [in]     nc     number of components
+ * @param [in]     r      受信する方向のbox（受信領域を使う）
+ * @param [in]     s      反対方向のbox（送信領域を使う）
+ * @note 隣接ランクが自ランクの方向で、MPIの送受信とバッファの代わりに用いる
+ *       反対方向の送信領域は、受信領域と同じ形となる
+ */
+template <class T> inline
+void BrickComm::copy_Box(T *array,
+                         const int nc,
+                         const CommBox *r,
+                         const CommBox *s)
+{
+  size_t rows, rlen;
+  getBoxRows(r->r_st, r->r_ed, nc, &rows, &rlen);
+  long long nr = (long long)rows;
+
+#pragma omp parallel for if( isParallelPack(rows * rlen * sizeof(T)) )
+  for (long long q=0; q<nr; q++) {
+    const T* sp = &array[getBoxRowOffset(s->s_st, s->s_ed, nc, q)];
+    T*       dp = &array[getBoxRowOffset(r->r_st, r->r_ed, nc, q)];
+    #pragma ivdep
+    for (size_t m=0; m<rlen; m++) dp[m] = sp[m];
+  }
+}
+
+
+// #########################################################
+/*
+ * @brief 隣接ランクが自ランクの方向の袖を、方向の順にコピー
+ * @param [in,out] array  array
+ * @param [in]     nc     number of components
+ * @param [in]     self   コピーする方向のビット
+ * @param [in]     box    方向ごとのbox (NOFACE)
+ */
+template <class T> inline
+void BrickComm::copy_Self(T *array,
+                          const int nc,
+                          const unsigned self,
+                          const CommBox *box)
+{
+  for (int dir=0; dir<NOFACE; dir++) {
+    if ( self & (1u << dir) ) copy_Box(array, nc, &box[dir], &box[getOppositeDir(dir)]);
+  }
+}
+
+#endif // _CB_PACK_BOX_H_
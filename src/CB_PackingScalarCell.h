@@ -45,11 +45,9 @@ void BrickComm::pack_SXcell(const T *array,
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
-      for( int j=0; j<NJ; j++ ){
-        #pragma novector
-        for( int i=0; i<gc; i++ ){
-          sendm[_IDX_SI(i,j,k,NJ,gc)] = array[_IDX_S3D(i,j,k,NI,NJ,VC)];
-        }
+      for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+        int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+        pack_Rows(&array[_IDX_S3D(0,j,k,NI,NJ,VC)], NI+2*VC, &sendm[_IDX_SI(0,j,k,NJ,gc)], gc, nj);
       }
     }
   }
@@ -58,11 +56,9 @@ void BrickComm::pack_SXcell(const T *array,
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
-      for( int j=0; j<NJ; j++ ){
-        #pragma novector
-        for( int i=0; i<gc; i++ ){
-          sendp[_IDX_SI(i,j,k,NJ,gc)] = array[_IDX_S3D(NI-gc+i,j,k,NI,NJ,VC)];
-        }
+      for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+        int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+        pack_Rows(&array[_IDX_S3D(NI-gc,j,k,NI,NJ,VC)], NI+2*VC, &sendp[_IDX_SI(0,j,k,NJ,gc)], gc, nj);
       }
     }
   }
@@ -96,11 +92,9 @@ void BrickComm::unpack_SXcell(T *array,
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
-      for( int j=0; j<NJ; j++ ){
-        #pragma novector
-        for( int i=0; i<gc; i++ ){
-          array[_IDX_S3D(i-gc,j,k,NI,NJ,VC)] = recvm[_IDX_SI(i,j,k,NJ,gc)];
-        }
+      for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+        int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+        unpack_Rows(&recvm[_IDX_SI(0,j,k,NJ,gc)], &array[_IDX_S3D(-gc,j,k,NI,NJ,VC)], NI+2*VC, gc, nj);
       }
     }
   }
@@ -109,11 +103,9 @@ void BrickComm::unpack_SXcell(T *array,
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
-      for( int j=0; j<NJ; j++ ){
-        #pragma novector
-        for( int i=0; i<gc; i++ ){
-          array[_IDX_S3D(NI+i,j,k,NI,NJ,VC)] = recvp[_IDX_SI(i,j,k,NJ,gc)];
-        }
+      for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+        int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+        unpack_Rows(&recvp[_IDX_SI(0,j,k,NJ,gc)], &array[_IDX_S3D(NI,j,k,NI,NJ,VC)], NI+2*VC, gc, nj);
       }
     }
   }
@@ -161,9 +153,9 @@ void BrickComm::pack_SYcell(const T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
       for( int j=0; j<gc; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
-          sendp[_IDX_SJ(i,j,k,NI,gc)] = array[_IDX_S3D(NI-gc+i,j,k,NI,NJ,VC)];
+          sendp[_IDX_SJ(i,j,k,NI,gc)] = array[_IDX_S3D(i,NJ-gc+j,k,NI,NJ,VC)];
         }
       }
     }
@@ -199,9 +191,9 @@ void BrickComm::unpack_SYcell(T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
       for( int j=0; j<gc; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
-          array[_IDX_S3D(i,j,k,NI,NJ,VC)] = recvm[_IDX_SJ(i,j,k,NI,gc)];
+          array[_IDX_S3D(i,j-gc,k,NI,NJ,VC)] = recvm[_IDX_SJ(i,j,k,NI,gc)];
         }
       }
     }
@@ -212,9 +204,9 @@ void BrickComm::unpack_SYcell(T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
       for( int j=0; j<gc; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
-          array[_IDX_S3D(i,j,k,NI,NJ,VC)] = recvp[_IDX_SJ(i,j,k,NI,gc)];
+          array[_IDX_S3D(i,NJ+j,k,NI,NJ,VC)] = recvp[_IDX_SJ(i,j,k,NI,gc)];
         }
       }
     }
@@ -250,7 +242,7 @@ void BrickComm::pack_SZcell(const T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<gc; k++ ){
       for( int j=0; j<NJ; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
           sendm[_IDX_SK(i,j,k,NI,NJ)] = array[_IDX_S3D(i,j,k,NI,NJ,VC)];
         }
@@ -263,9 +255,9 @@ void BrickComm::pack_SZcell(const T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<gc; k++ ){
       for( int j=0; j<NJ; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
-          sendp[_IDX_SK(i,j,k,NI,NJ)] = array[_IDX_S3D(i,j,k,NI,NJ,VC)];
+          sendp[_IDX_SK(i,j,k,NI,NJ)] = array[_IDX_S3D(i,j,NK-gc+k,NI,NJ,VC)];
         }
       }
     }
@@ -301,9 +293,9 @@ void BrickComm::unpack_SZcell(T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<gc; k++ ){
       for( int j=0; j<NJ; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
-          array[_IDX_S3D(i,j,k,NI,NJ,VC)] = recvm[_IDX_SK(i,j,k,NI,NJ)];
+          array[_IDX_S3D(i,j,k-gc,NI,NJ,VC)] = recvm[_IDX_SK(i,j,k,NI,NJ)];
         }
       }
     }
@@ -314,9 +306,9 @@ void BrickComm::unpack_SZcell(T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<gc; k++ ){
       for( int j=0; j<NJ; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
-          array[_IDX_S3D(i,j,k,NI,NJ,VC)] = recvp[_IDX_SK(i,j,k,NI,NJ)];
+          array[_IDX_S3D(i,j,NK+k,NI,NJ,VC)] = recvp[_IDX_SK(i,j,k,NI,NJ)];
         }
       }
     }
@@ -348,7 +340,6 @@ bool BrickComm::pack_SEcell(T *array,
   int NJ = size[1];
   int NK = size[2];
   int VC = halo_width;
-  int tag = 0;
   size_t ptr = 0;
 
   //// X edge ////
@@ -372,6 +363,7 @@ bool BrickComm::pack_SEcell(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
       
       // pack
@@ -381,7 +373,7 @@ bool BrickComm::pack_SEcell(T *array,
 #pragma omp parallel for collapse(2)
         for( int k=0; k<gc; k++ ){
           for( int j=0; j<gc; j++ ){
-            #pragma novector
+            #pragma ivdep
             for( int i=0; i<NI; i++ ){
               sendptr[_IDX_S3D(i,j,k,NI,gc,0)] = array[_IDX_S3D(i,j,k,NI,NJ,VC)];
             }
@@ -393,7 +385,7 @@ bool BrickComm::pack_SEcell(T *array,
 #pragma omp parallel for collapse(2)
         for( int k=0; k<gc; k++ ){
           for( int j=NJ-gc; j<NJ; j++ ){
-            #pragma novector
+            #pragma ivdep
             for( int i=0; i<NI; i++ ){
               sendptr[_IDX_S3D(i,j-(NJ-gc),k,NI,gc,0)] = array[_IDX_S3D(i,j,k,NI,NJ,VC)];
             }
@@ -405,7 +397,7 @@ bool BrickComm::pack_SEcell(T *array,
 #pragma omp parallel for collapse(2)
         for( int k=NK-gc; k<NK; k++ ){
           for( int j=0; j<gc; j++ ){
-            #pragma novector
+            #pragma ivdep
             for( int i=0; i<NI; i++ ){
               sendptr[_IDX_S3D(i,j,k-(NK-gc),NI,gc,0)] = array[_IDX_S3D(i,j,k,NI,NJ,VC)];
             }
@@ -417,7 +409,7 @@ bool BrickComm::pack_SEcell(T *array,
 #pragma omp parallel for collapse(2)
         for( int k=NK-gc; k<NK; k++ ){
           for( int j=NJ-gc; j<NJ; j++ ){
-            #pragma novector
+            #pragma ivdep
             for( int i=0; i<NI; i++ ){
               sendptr[_IDX_S3D(i,j-(NJ-gc),k-(NK-gc),NI,gc,0)] = array[_IDX_S3D(i,j,k,NI,NJ,VC)];
             }
@@ -438,6 +430,7 @@ bool BrickComm::pack_SEcell(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -466,6 +459,7 @@ bool BrickComm::pack_SEcell(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -532,6 +526,7 @@ bool BrickComm::pack_SEcell(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -560,6 +555,7 @@ bool BrickComm::pack_SEcell(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -626,6 +622,7 @@ bool BrickComm::pack_SEcell(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -671,7 +668,7 @@ void BrickComm::unpack_SEcell(T *array,
 #pragma omp parallel for collapse(2)
         for( int k=0-gc; k<0; k++ ){
           for( int j=0-gc; j<0; j++ ){
-            #pragma novector
+            #pragma ivdep
             for( int i=0; i<NI; i++ ){
               array[_IDX_S3D(i,j,k,NI,NJ,VC)] = recvptr[_IDX_S3D(i,j-(0-gc),k-(0-gc),NI,gc,0)];
             }
@@ -683,7 +680,7 @@ void BrickComm::unpack_SEcell(T *array,
 #pragma omp parallel for collapse(2)
         for( int k=0-gc; k<0; k++ ){
           for( int j=NJ; j<NJ+gc; j++ ){
-            #pragma novector
+            #pragma ivdep
             for( int i=0; i<NI; i++ ){
               array[_IDX_S3D(i,j,k,NI,NJ,VC)] = recvptr[_IDX_S3D(i,j-(NJ),k-(0-gc),NI,gc,0)];
             }
@@ -695,7 +692,7 @@ void BrickComm::unpack_SEcell(T *array,
 #pragma omp parallel for collapse(2)
         for( int k=NK; k<NK+gc; k++ ){
           for( int j=0-gc; j<0; j++ ){
-            #pragma novector
+            #pragma ivdep
             for( int i=0; i<NI; i++ ){
               array[_IDX_S3D(i,j,k,NI,NJ,VC)] = recvptr[_IDX_S3D(i,j-(0-gc),k-(NK),NI,gc,0)];
             }
@@ -707,7 +704,7 @@ void BrickComm::unpack_SEcell(T *array,
 #pragma omp parallel for collapse(2)
         for( int k=NK; k<NK+gc; k++ ){
           for( int j=NJ; j<NJ+gc; j++ ){
-            #pragma novector
+            #pragma ivdep
             for( int i=0; i<NI; i++ ){
               array[_IDX_S3D(i,j,k,NI,NJ,VC)] = recvptr[_IDX_S3D(i,j-(NJ),k-(NK),NI,gc,0)];
             }
@@ -872,7 +869,6 @@ bool BrickComm::pack_SCcell(T *array,
   int NJ = size[1];
   int NK = size[2];
   int VC = halo_width;
-  int tag = 0;
   size_t ptr = 0;
 
   //// 8 corner ////
@@ -896,6 +892,7 @@ bool BrickComm::pack_SCcell(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -1010,6 +1007,7 @@ bool BrickComm::pack_SCcell(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
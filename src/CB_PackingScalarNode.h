@@ -41,6 +41,9 @@ void BrickComm::pack_SXnode(const T *array,
   int NK = size[2];
   int VC = halo_width;
 
+  // プラス側の送信の開始 (setCommBox()と同じ、gc=1は共有する格子点の1つ内側)
+  int ps = (gc == 1) ? 2 : gc;
+
 /*
                  <--gc-->
 rankA  [NI-3] [NI-2] [NI-1]  [NI]  [NI+1]
@@ -55,11 +58,9 @@ rankB   [-2]   [-1]    [0]    [1]    [2]
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
-      for( int j=0; j<NJ; j++ ){
-        #pragma novector
-        for( int i=0; i<gc; i++ ){
-          sendm[_IDX_SI(i,j,k,NJ,gc)] = array[_IDX_S3D(i+1,j,k,NI,NJ,VC)];
-        }
+      for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+        int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+        pack_Rows(&array[_IDX_S3D(1,j,k,NI,NJ,VC)], NI+2*VC, &sendm[_IDX_SI(0,j,k,NJ,gc)], gc, nj);
       }
     }
   }
@@ -69,11 +70,9 @@ rankB   [-2]   [-1]    [0]    [1]    [2]
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
-      for( int j=0; j<NJ; j++ ){
-        #pragma novector
-        for( int i=0; i<gc; i++ ){
-          sendp[_IDX_SI(i,j,k,NJ,gc)] = array[_IDX_S3D(NI-2+i,j,k,NI,NJ,VC)];
-        }
+      for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+        int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+        pack_Rows(&array[_IDX_S3D(NI-ps,j,k,NI,NJ,VC)], NI+2*VC, &sendp[_IDX_SI(0,j,k,NJ,gc)], gc, nj);
       }
     }
   }
@@ -116,11 +115,9 @@ rankB   [-2]   [-1]    [0]    [1]    [2]
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
-      for( int j=0; j<NJ; j++ ){
-        #pragma novector
-        for( int i=0; i<gc; i++ ){
-          array[_IDX_S3D(i-1,j,k,NI,NJ,VC)] = recvm[_IDX_SI(i,j,k,NJ,gc)];
-        }
+      for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+        int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+        unpack_Rows(&recvm[_IDX_SI(0,j,k,NJ,gc)], &array[_IDX_S3D(-1,j,k,NI,NJ,VC)], NI+2*VC, gc, nj);
       }
     }
   }
@@ -130,11 +127,9 @@ rankB   [-2]   [-1]    [0]    [1]    [2]
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
-      for( int j=0; j<NJ; j++ ){
-        #pragma novector
-        for( int i=0; i<gc; i++ ){
-          array[_IDX_S3D(NI+i,j,k,NI,NJ,VC)] = recvp[_IDX_SI(i,j,k,NJ,gc)];
-        }
+      for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+        int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+        unpack_Rows(&recvp[_IDX_SI(0,j,k,NJ,gc)], &array[_IDX_S3D(NI,j,k,NI,NJ,VC)], NI+2*VC, gc, nj);
       }
     }
   }
@@ -164,12 +159,15 @@ void BrickComm::pack_SYnode(const T *array,
   int NK = size[2];
   int VC = halo_width;
 
+  // プラス側の送信の開始 (setCommBox()と同じ、gc=1は共有する格子点の1つ内側)
+  int ps = (gc == 1) ? 2 : gc;
+
   if( nIDm >= 0 )
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
       for( int j=0; j<gc; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
           sendm[_IDX_SJ(i,j,k,NI,gc)] = array[_IDX_S3D(i,j+1,k,NI,NJ,VC)];
         }
@@ -182,9 +180,9 @@ void BrickComm::pack_SYnode(const T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
       for( int j=0; j<gc; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
-          sendp[_IDX_SJ(i,j,k,NI,gc)] = array[_IDX_S3D(i,NJ-2+j,k,NI,NJ,VC)];
+          sendp[_IDX_SJ(i,j,k,NI,gc)] = array[_IDX_S3D(i,NJ-ps+j,k,NI,NJ,VC)];
         }
       }
     }
@@ -220,7 +218,7 @@ void BrickComm::unpack_SYnode(T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
       for( int j=0; j<gc; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
           array[_IDX_S3D(i,j-1,k,NI,NJ,VC)] = recvm[_IDX_SJ(i,j,k,NI,gc)];
         }
@@ -233,7 +231,7 @@ void BrickComm::unpack_SYnode(T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<NK; k++ ){
       for( int j=0; j<gc; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
           array[_IDX_S3D(i,NJ+j,k,NI,NJ,VC)] = recvp[_IDX_SJ(i,j,k,NI,gc)];
         }
@@ -266,12 +264,15 @@ void BrickComm::pack_SZnode(const T *array,
   int NK = size[2];
   int VC = halo_width;
 
+  // プラス側の送信の開始 (setCommBox()と同じ、gc=1は共有する格子点の1つ内側)
+  int ps = (gc == 1) ? 2 : gc;
+
   if( nIDm >= 0 )
   {
 #pragma omp parallel for collapse(2)
     for( int k=0; k<gc; k++ ){
       for( int j=0; j<NJ; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
           sendm[_IDX_SK(i,j,k,NI,NJ)] = array[_IDX_S3D(i,j,k+1,NI,NJ,VC)];
         }
@@ -284,9 +285,9 @@ void BrickComm::pack_SZnode(const T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<gc; k++ ){
       for( int j=0; j<NJ; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
-          sendp[_IDX_SK(i,j,k,NI,NJ)] = array[_IDX_S3D(i,j,NK-2+k,NI,NJ,VC)];
+          sendp[_IDX_SK(i,j,k,NI,NJ)] = array[_IDX_S3D(i,j,NK-ps+k,NI,NJ,VC)];
         }
       }
     }
@@ -322,7 +323,7 @@ void BrickComm::unpack_SZnode(T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<gc; k++ ){
       for( int j=0; j<NJ; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
           array[_IDX_S3D(i,j,k-1,NI,NJ,VC)] = recvm[_IDX_SK(i,j,k,NI,NJ)];
         }
@@ -335,7 +336,7 @@ void BrickComm::unpack_SZnode(T *array,
 #pragma omp parallel for collapse(2)
     for( int k=0; k<gc; k++ ){
       for( int j=0; j<NJ; j++ ){
-        #pragma novector
+        #pragma ivdep
         for( int i=0; i<NI; i++ ){
           array[_IDX_S3D(i,j,NK+k,NI,NJ,VC)] = recvp[_IDX_SK(i,j,k,NI,NJ)];
         }
@@ -369,7 +370,6 @@ bool BrickComm::pack_SEnode(T *array,
   int NJ = size[1];
   int NK = size[2];
   int VC = halo_width;
-  int tag = 0;
   size_t ptr = 0;
 
   //// X edge ////
@@ -393,6 +393,7 @@ bool BrickComm::pack_SEnode(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -455,6 +456,7 @@ bool BrickComm::pack_SEnode(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -483,6 +485,7 @@ bool BrickComm::pack_SEnode(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -545,6 +548,7 @@ bool BrickComm::pack_SEnode(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -573,6 +577,7 @@ bool BrickComm::pack_SEnode(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -635,6 +640,7 @@ bool BrickComm::pack_SEnode(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -869,7 +875,6 @@ bool BrickComm::pack_SCnode(T *array,
   int NJ = size[1];
   int NK = size[2];
   int VC = halo_width;
-  int tag = 0;
   size_t ptr = 0;
 
   //// 8 corner ////
@@ -893,6 +898,7 @@ bool BrickComm::pack_SCnode(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -999,6 +1005,7 @@ bool BrickComm::pack_SCnode(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -46,11 +46,9 @@ void BrickComm::pack_VXcell(const T *array,
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
-        for( int j=0; j<NJ; j++ ){
-          #pragma novector
-          for( int i=0; i<gc; i++ ){
-            sendm[_IDX_VI(i,j,k,l,NJ,NK,gc)] = array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)];
-          }
+        for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+          int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+          pack_Rows(&array[_IDX_V3D(0,j,k,l,NI,NJ,NK,VC)], NI+2*VC, &sendm[_IDX_VI(0,j,k,l,NJ,NK,gc)], gc, nj);
         }
       }
     }
@@ -61,11 +59,9 @@ void BrickComm::pack_VXcell(const T *array,
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
-        for( int j=0; j<NJ; j++ ){
-          #pragma novector
-          for( int i=0; i<gc; i++ ){
-            sendp[_IDX_VI(i,j,k,l,NJ,NK,gc)] = array[_IDX_V3D(NI-gc+i,j,k,l,NI,NJ,NK,VC)];
-          }
+        for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+          int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+          pack_Rows(&array[_IDX_V3D(NI-gc,j,k,l,NI,NJ,NK,VC)], NI+2*VC, &sendp[_IDX_VI(0,j,k,l,NJ,NK,gc)], gc, nj);
         }
       }
     }
@@ -101,11 +97,9 @@ void BrickComm::unpack_VXcell(T *array,
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
-        for( int j=0; j<NJ; j++ ){
-          #pragma novector
-          for( int i=0; i<gc; i++ ){
-            array[_IDX_V3D(i-gc,j,k,l,NI,NJ,NK,VC)] = recvm[_IDX_VI(i,j,k,l,NJ,NK,gc)];
-          }
+        for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+          int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+          unpack_Rows(&recvm[_IDX_VI(0,j,k,l,NJ,NK,gc)], &array[_IDX_V3D(-gc,j,k,l,NI,NJ,NK,VC)], NI+2*VC, gc, nj);
         }
       }
     }
@@ -116,11 +110,9 @@ void BrickComm::unpack_VXcell(T *array,
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
-        for( int j=0; j<NJ; j++ ){
-          #pragma novector
-          for( int i=0; i<gc; i++ ){
-            array[_IDX_V3D(NI+i,j,k,l,NI,NJ,NK,VC)] = recvp[_IDX_VI(i,j,k,l,NJ,NK,gc)];
-          }
+        for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+          int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+          unpack_Rows(&recvp[_IDX_VI(0,j,k,l,NJ,NK,gc)], &array[_IDX_V3D(NI,j,k,l,NI,NJ,NK,VC)], NI+2*VC, gc, nj);
         }
       }
     }
@@ -157,7 +149,7 @@ void BrickComm::pack_VYcell(const T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
         for( int j=0; j<gc; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
             sendm[_IDX_VJ(i,j,k,l,NI,NK,gc)] = array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)];
           }
@@ -172,9 +164,9 @@ void BrickComm::pack_VYcell(const T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
         for( int j=0; j<gc; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
-            sendp[_IDX_VJ(i,j,k,l,NI,NK,gc)] = array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)];
+            sendp[_IDX_VJ(i,j,k,l,NI,NK,gc)] = array[_IDX_V3D(i,NJ-gc+j,k,l,NI,NJ,NK,VC)];
           }
         }
       }
@@ -212,9 +204,9 @@ void BrickComm::unpack_VYcell(T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
         for( int j=0; j<gc; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
-            array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)] = recvm[_IDX_VJ(i,j,k,l,NI,NK,gc)];
+            array[_IDX_V3D(i,j-gc,k,l,NI,NJ,NK,VC)] = recvm[_IDX_VJ(i,j,k,l,NI,NK,gc)];
           }
         }
       }
@@ -227,9 +219,9 @@ void BrickComm::unpack_VYcell(T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
         for( int j=0; j<gc; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
-            array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)] = recvp[_IDX_VJ(i,j,k,l,NI,NK,gc)];
+            array[_IDX_V3D(i,NJ+j,k,l,NI,NJ,NK,VC)] = recvp[_IDX_VJ(i,j,k,l,NI,NK,gc)];
           }
         }
       }
@@ -267,7 +259,7 @@ void BrickComm::pack_VZcell(const T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<gc; k++ ){
         for( int j=0; j<NJ; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
             sendm[_IDX_VK(i,j,k,l,NI,NJ,gc)] = array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)];
           }
@@ -282,9 +274,9 @@ void BrickComm::pack_VZcell(const T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<gc; k++ ){
         for( int j=0; j<NJ; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
-            sendp[_IDX_VK(i,j,k,l,NI,NJ,gc)] = array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)];
+            sendp[_IDX_VK(i,j,k,l,NI,NJ,gc)] = array[_IDX_V3D(i,j,NK-gc+k,l,NI,NJ,NK,VC)];
           }
         }
       }
@@ -322,9 +314,9 @@ void BrickComm::unpack_VZcell(T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<gc; k++ ){
         for( int j=0; j<NJ; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
-            array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)] = recvm[_IDX_VK(i,j,k,l,NI,NJ,gc)];
+            array[_IDX_V3D(i,j,k-gc,l,NI,NJ,NK,VC)] = recvm[_IDX_VK(i,j,k,l,NI,NJ,gc)];
           }
         }
       }
@@ -337,9 +329,9 @@ void BrickComm::unpack_VZcell(T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<gc; k++ ){
         for( int j=0; j<NJ; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
-            array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)] = recvp[_IDX_VK(i,j,k,l,NI,NJ,gc)];
+            array[_IDX_V3D(i,j,NK+k,l,NI,NJ,NK,VC)] = recvp[_IDX_VK(i,j,k,l,NI,NJ,gc)];
           }
         }
       }
@@ -371,7 +363,6 @@ bool BrickComm::pack_VEcell(T *array,
   int NJ = size[1];
   int NK = size[2];
   int VC = halo_width;
-  int tag = 0;
   size_t ptr = 0;
 
   //// X edge ////
@@ -395,6 +386,7 @@ bool BrickComm::pack_VEcell(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -405,7 +397,7 @@ bool BrickComm::pack_VEcell(T *array,
         for( int l=0; l<3; l++ ){
           for( int k=0; k<gc; k++ ){
             for( int j=0; j<gc; j++ ){
-              #pragma novector
+              #pragma ivdep
               for( int i=0; i<NI; i++ ){
                 sendptr[_IDX_V3D(i,j,k,l,NI,gc,gc,0)] = array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)];
               }
@@ -419,7 +411,7 @@ bool BrickComm::pack_VEcell(T *array,
         for( int l=0; l<3; l++ ){
           for( int k=0; k<gc; k++ ){
             for( int j=NJ-gc; j<NJ; j++ ){
-              #pragma novector
+              #pragma ivdep
               for( int i=0; i<NI; i++ ){
                 sendptr[_IDX_V3D(i,j-(NJ-gc),k,l,NI,gc,gc,0)] = array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)];
               }
@@ -433,7 +425,7 @@ bool BrickComm::pack_VEcell(T *array,
         for( int l=0; l<3; l++ ){
           for( int k=NK-gc; k<NK; k++ ){
             for( int j=0; j<gc; j++ ){
-              #pragma novector
+              #pragma ivdep
               for( int i=0; i<NI; i++ ){
                 sendptr[_IDX_V3D(i,j,k-(NK-gc),l,NI,gc,gc,0)] = array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)];
               }
@@ -447,7 +439,7 @@ bool BrickComm::pack_VEcell(T *array,
         for( int l=0; l<3; l++ ){
           for( int k=NK-gc; k<NK; k++ ){
             for( int j=NJ-gc; j<NJ; j++ ){
-              #pragma novector
+              #pragma ivdep
               for( int i=0; i<NI; i++ ){
                 sendptr[_IDX_V3D(i,j-(NJ-gc),k-(NK-gc),l,NI,gc,gc,0)] = array[_IDX_V3D(i,j,k,l,NI,NJ,NK,VC)];
               }
@@ -469,6 +461,7 @@ bool BrickComm::pack_VEcell(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -497,6 +490,7 @@ bool BrickComm::pack_VEcell(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -567,6 +561,7 @@ bool BrickComm::pack_VEcell(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -595,6 +590,7 @@ bool BrickComm::pack_VEcell(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -665,6 +661,7 @@ bool BrickComm::pack_VEcell(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -923,7 +920,6 @@ bool BrickComm::pack_VCcell(T *array,
   int NJ = size[1];
   int NK = size[2];
   int VC = halo_width;
-  int tag = 0;
   size_t ptr = 0;
 
   //// 8 corner ////
@@ -947,6 +943,7 @@ bool BrickComm::pack_VCcell(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -1069,6 +1066,7 @@ bool BrickComm::pack_VCcell(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
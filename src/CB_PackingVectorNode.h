@@ -41,6 +41,9 @@ void BrickComm::pack_VXnode(const T *array,
   int NK = size[2];
   int VC = halo_width;
 
+  // プラス側の送信の開始 (setCommBox()と同じ、gc=1は共有する格子点の1つ内側)
+  int ps = (gc == 1) ? 2 : gc;
+
   /*
                    <--gc-->
   rankA  [NI-3] [NI-2] [NI-1]  [NI]  [NI+1]
@@ -54,11 +57,9 @@ void BrickComm::pack_VXnode(const T *array,
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
-        for( int j=0; j<NJ; j++ ){
-          #pragma novector
-          for( int i=0; i<gc; i++ ){
-            sendm[_IDX_VI(i,j,k,l,NJ,NK,gc)] = array[_IDX_V3D(i+1,j,k,l,NI,NJ,NK,VC)];
-          }
+        for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+          int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+          pack_Rows(&array[_IDX_V3D(1,j,k,l,NI,NJ,NK,VC)], NI+2*VC, &sendm[_IDX_VI(0,j,k,l,NJ,NK,gc)], gc, nj);
         }
       }
     }
@@ -69,11 +70,9 @@ void BrickComm::pack_VXnode(const T *array,
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
-        for( int j=0; j<NJ; j++ ){
-          #pragma novector
-          for( int i=0; i<gc; i++ ){
-            sendp[_IDX_VI(i,j,k,l,NJ,NK,gc)] = array[_IDX_V3D(NI-2+i,j,k,l,NI,NJ,NK,VC)];
-          }
+        for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+          int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+          pack_Rows(&array[_IDX_V3D(NI-ps,j,k,l,NI,NJ,NK,VC)], NI+2*VC, &sendp[_IDX_VI(0,j,k,l,NJ,NK,gc)], gc, nj);
         }
       }
     }
@@ -109,11 +108,9 @@ void BrickComm::unpack_VXnode(T *array,
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
-        for( int j=0; j<NJ; j++ ){
-          #pragma novector
-          for( int i=0; i<gc; i++ ){
-            array[_IDX_V3D(i-1,j,k,l,NI,NJ,NK,VC)] = recvm[_IDX_VI(i,j,k,l,NJ,NK,gc)];
-          }
+        for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+          int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+          unpack_Rows(&recvm[_IDX_VI(0,j,k,l,NJ,NK,gc)], &array[_IDX_V3D(-1,j,k,l,NI,NJ,NK,VC)], NI+2*VC, gc, nj);
         }
       }
     }
@@ -124,11 +121,9 @@ void BrickComm::unpack_VXnode(T *array,
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
-        for( int j=0; j<NJ; j++ ){
-          #pragma novector
-          for( int i=0; i<gc; i++ ){
-            array[_IDX_V3D(NI+i,j,k,l,NI,NJ,NK,VC)] = recvp[_IDX_VI(i,j,k,l,NJ,NK,gc)];
-          }
+        for( int j=0; j<NJ; j+=CB_PACK_ROWS ){
+          int nj = (NJ-j < CB_PACK_ROWS) ? NJ-j : CB_PACK_ROWS;
+          unpack_Rows(&recvp[_IDX_VI(0,j,k,l,NJ,NK,gc)], &array[_IDX_V3D(NI,j,k,l,NI,NJ,NK,VC)], NI+2*VC, gc, nj);
         }
       }
     }
@@ -159,13 +154,16 @@ void BrickComm::pack_VYnode(const T *array,
   int NK = size[2];
   int VC = halo_width;
 
+  // プラス側の送信の開始 (setCommBox()と同じ、gc=1は共有する格子点の1つ内側)
+  int ps = (gc == 1) ? 2 : gc;
+
   if( nIDm >= 0 )
   {
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
         for( int j=0; j<gc; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
             sendm[_IDX_VJ(i,j,k,l,NI,NK,gc)] = array[_IDX_V3D(i,j+1,k,l,NI,NJ,NK,VC)];
           }
@@ -180,9 +178,9 @@ void BrickComm::pack_VYnode(const T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
         for( int j=0; j<gc; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
-            sendp[_IDX_VJ(i,j,k,l,NI,NK,gc)] = array[_IDX_V3D(i,NJ-2+j,k,l,NI,NJ,NK,VC)];
+            sendp[_IDX_VJ(i,j,k,l,NI,NK,gc)] = array[_IDX_V3D(i,NJ-ps+j,k,l,NI,NJ,NK,VC)];
           }
         }
       }
@@ -220,7 +218,7 @@ void BrickComm::unpack_VYnode(T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
         for( int j=0; j<gc; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
             array[_IDX_V3D(i,j-1,k,l,NI,NJ,NK,VC)] = recvm[_IDX_VJ(i,j,k,l,NI,NK,gc)];
           }
@@ -235,7 +233,7 @@ void BrickComm::unpack_VYnode(T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<NK; k++ ){
         for( int j=0; j<gc; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
             array[_IDX_V3D(i,NJ+j,k,l,NI,NJ,NK,VC)] = recvp[_IDX_VJ(i,j,k,l,NI,NK,gc)];
           }
@@ -269,13 +267,16 @@ void BrickComm::pack_VZnode(const T *array,
   int NK = size[2];
   int VC = halo_width;
 
+  // プラス側の送信の開始 (setCommBox()と同じ、gc=1は共有する格子点の1つ内側)
+  int ps = (gc == 1) ? 2 : gc;
+
   if( nIDm >= 0 )
   {
 #pragma omp parallel for collapse(3)
     for (int l=0; l<3; l++) {
       for( int k=0; k<gc; k++ ){
         for( int j=0; j<NJ; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
             sendm[_IDX_VK(i,j,k,l,NI,NJ,gc)] = array[_IDX_V3D(i,j,k+1,l,NI,NJ,NK,VC)];
           }
@@ -290,9 +291,9 @@ void BrickComm::pack_VZnode(const T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<gc; k++ ){
         for( int j=0; j<NJ; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
-            sendp[_IDX_VK(i,j,k,l,NI,NJ,gc)] = array[_IDX_V3D(i,j,NK-2+k,l,NI,NJ,NK,VC)];
+            sendp[_IDX_VK(i,j,k,l,NI,NJ,gc)] = array[_IDX_V3D(i,j,NK-ps+k,l,NI,NJ,NK,VC)];
           }
         }
       }
@@ -330,7 +331,7 @@ void BrickComm::unpack_VZnode(T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<gc; k++ ){
         for( int j=0; j<NJ; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
             array[_IDX_V3D(i,j,k-1,l,NI,NJ,NK,VC)] = recvm[_IDX_VK(i,j,k,l,NI,NJ,gc)];
           }
@@ -345,7 +346,7 @@ void BrickComm::unpack_VZnode(T *array,
     for (int l=0; l<3; l++) {
       for( int k=0; k<gc; k++ ){
         for( int j=0; j<NJ; j++ ){
-          #pragma novector
+          #pragma ivdep
           for( int i=0; i<NI; i++ ){
             array[_IDX_V3D(i,j,NK+k,l,NI,NJ,NK,VC)] = recvp[_IDX_VK(i,j,k,l,NI,NJ,gc)];
           }
@@ -380,7 +381,6 @@ bool BrickComm::pack_VEnode(T *array,
   int NJ = size[1];
   int NK = size[2];
   int VC = halo_width;
-  int tag = 0;
   size_t ptr = 0;
 
   //// X edge ////
@@ -404,6 +404,7 @@ bool BrickComm::pack_VEnode(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -474,6 +475,7 @@ bool BrickComm::pack_VEnode(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -502,6 +504,7 @@ bool BrickComm::pack_VEnode(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -572,6 +575,7 @@ bool BrickComm::pack_VEnode(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -600,6 +604,7 @@ bool BrickComm::pack_VEnode(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -670,6 +675,7 @@ bool BrickComm::pack_VEnode(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
@@ -928,7 +934,6 @@ bool BrickComm::pack_VCnode(T *array,
   int NJ = size[1];
   int NK = size[2];
   int VC = halo_width;
-  int tag = 0;
   size_t ptr = 0;
 
   //// 8 corner ////
@@ -952,6 +957,7 @@ bool BrickComm::pack_VCnode(T *array,
       if ( !IrecvData(recvptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(getOppositeDir(dir)),
                       &req[dir*2]) ) return false;
 
       // pack
@@ -1074,6 +1080,7 @@ bool BrickComm::pack_VCnode(T *array,
       if ( !IsendData(sendptr,
                       sz,
                       comm_tbl[dir],
+                      getTag(dir),
                       &req[dir*2+1]) ) return false;
 
       // pointer
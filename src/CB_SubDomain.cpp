@@ -1137,6 +1137,17 @@ void SubDomain::getHeadIndex()
 }
 
 
+// #########################################################
+// 分割位置の袖を含むインデクスを、周期境界では反対側へ折り返す
+// 周期境界でない軸の外側は-1
+static inline int wrapDivision(const int i, const int n, const int prd)
+{
+  if ( i >= 0 && i < n ) return i;
+  if ( !prd ) return -1;
+  return ( i < 0 ) ? i + n : i - n;
+}
+
+
 // #########################################################
 /*
 * @fn createRankTable
@@ -1148,11 +1159,14 @@ void SubDomain::getHeadIndex()
 *
 * Rank |   -1   |    0    |    1    |    2    |    3    |    4    |
 *        halo   <---------------  Inner region   ------->   halo
+*
+*       周期境界の軸では、袖に反対側のランクを置く（面・辺・点とも）
+*       分割数1の軸では、隣接ランクは自ランクとなる
 */
 bool SubDomain::createRankTable()
 {
   // numProc=1のとき
-  if (numProc == 1)
+  if (numProc == 1 && !periodic[0] && !periodic[1] && !periodic[2])
   {
     for (int i=0; i<NOFACE; i++) {
       comm_tbl[i] = -1;
@@ -1190,6 +1204,21 @@ bool SubDomain::createRankTable()
     }
   }
 
+  // 周期境界の軸の袖
+  if ( periodic[0] || periodic[1] || periodic[2] ) {
+    for (int k=-1; k<=nz; k++) {
+      for (int j=-1; j<=ny; j++) {
+        for (int i=-1; i<=nx; i++) {
+          int ii = wrapDivision(i, nx, periodic[0]);
+          int jj = wrapDivision(j, ny, periodic[1]);
+          int kk = wrapDivision(k, nz, periodic[2]);
+          if ( ii < 0 || jj < 0 || kk < 0 ) continue;
+          rt[_IDX_S3D(i, j, k, nx, ny, 1)] = _IDX_S3D(ii, jj, kk, nx, ny, 0);
+        }
+      }
+    }
+  }
+
   // Neighbor rank ID for comm
   #pragma omp parallel for collapse(2)
   for (int k=0; k<nz; k++) {
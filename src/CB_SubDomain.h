@@ -162,6 +162,7 @@ private:
   int f_index;          ///< Findex (0-OFF, 1-ON) @note 関連するところは head index
   int numProc;          ///< 全ランク数
   int ranking_opt;      ///< ランキングのオプション（0=cubical, default, 1=vector）
+  int periodic[3];      ///< 周期境界の軸 (0-OFF, 1-ON)
 
 
 public:
@@ -182,6 +183,7 @@ public:
       size[i]       = 0;
       G_size[i]     = 0;
       G_div[i]      = 0;
+      periodic[i]   = 0;
     }
     sd = NULL;
   }
@@ -208,6 +210,7 @@ public:
     this->myRank      = m_myrank;
     this->mpi_comm    = m_comm;
     this->ranking_opt = priority;
+    this->periodic[0] = this->periodic[1] = this->periodic[2] = 0;
 
     if (m_type == "node" || m_type == "cell") {
       // ok
@@ -362,6 +365,25 @@ public:
     m_sz[2] = head[2];
   }
 
+  // @brief 周期境界の軸を指定する
+  // @param [in] m_prd 各軸の周期境界 (0-OFF, 1-ON)
+  // @note createRankTable()の前に呼ぶ
+  void setPeriodic(const int* m_prd)
+  {
+    periodic[0] = m_prd[0] ? 1 : 0;
+    periodic[1] = m_prd[1] ? 1 : 0;
+    periodic[2] = m_prd[2] ? 1 : 0;
+  }
+
+  // @brief 周期境界の軸を返す
+  // @param [out] m_prd 各軸の周期境界 (0-OFF, 1-ON)
+  void getPeriodic(int* m_prd)
+  {
+    m_prd[0] = periodic[0];
+    m_prd[1] = periodic[1];
+    m_prd[2] = periodic[2];
+  }
+
   // @brief 通信テーブルを返す
   // @param [out] m_tbl 通信テーブル
   void getCommTable(int* m_tbl)